@@ -0,0 +1,52 @@
+#!/bin/sh
+
+#
+# Compares the time-to-depth of the default and the compact (compacttt=yes)
+# transposition table layouts at a fixed hash size, using speedtest with a
+# fixed search depth. Run from the src directory:
+#
+#   ../scripts/tt_layout_compare.sh [threads] [hash MiB] [depth] [ARCH]
+#
+# The defaults are all processors, 1024 MiB, depth 20 and the native ARCH.
+# Both builds search the same positions, so the lower total search time is the
+# better layout for that hash size and thread count. The builds are made in a
+# temporary copy of the tree, leaving the objects and binary in src untouched.
+#
+
+threads=${1:-$(nproc 2>/dev/null || echo 1)}
+hash=${2:-1024}
+depth=${3:-20}
+arch=${4:-native}
+
+tmp=$(mktemp -d) || exit 1
+trap 'rm -rf "$tmp"' EXIT
+
+# The network download of the build needs the scripts next to src
+mkdir "$tmp/tree" && cp -R ../src ../scripts "$tmp/tree/" || exit 1
+
+for layout in no yes; do
+  make -s -C "$tmp/tree/src" clean >/dev/null 2>&1
+  if ! make -s -C "$tmp/tree/src" -j"$threads" build ARCH="$arch" compacttt="$layout" \
+    >/dev/null 2>&1; then
+    >&2 echo "build with compacttt=$layout failed"
+    exit 1
+  fi
+  cp "$tmp/tree/src/stockfish" "$tmp/stockfish-$layout"
+done
+
+echo "threads $threads, hash $hash MiB, depth $depth"
+
+for layout in no yes; do
+  "$tmp/stockfish-$layout" speedtest "$threads" "$hash" 1 "$depth" 2>"$tmp/$layout.log" >/dev/null
+  time=$(grep "Total search time" "$tmp/$layout.log" | sed "s/.*: //")
+  nodes=$(grep "Total nodes searched" "$tmp/$layout.log" | sed "s/.*: //")
+  layoutInfo=$(grep "TT layout" "$tmp/$layout.log" | sed "s/.*: //")
+
+  if [ -z "$time" ]; then
+    >&2 echo "speedtest with compacttt=$layout failed, see below"
+    >&2 cat "$tmp/$layout.log"
+    exit 1
+  fi
+
+  echo "compacttt=$layout ($layoutInfo): $time s, $nodes nodes"
+done
@@ -401,7 +401,9 @@ std::vector<std::string> setup_bench(const std::string& currentFen, std::istream
     std::string fenFile   = (is >> token) ? token : "default";
     std::string limitType = (is >> token) ? token : "depth";
 
-    go = limitType == "eval" ? "eval" : "go " + limitType + " " + limit;
+    go = limitType == "eval"      ? "eval"
+       : limitType == "evalbatch" ? "evalbatch " + limit
+                                  : "go " + limitType + " " + limit;
 
     if (fenFile == "default")
         fens = Defaults;
@@ -473,6 +475,16 @@ BenchmarkSetup setup_benchmark(std::istream& is) {
     setup.filledInvocation += std::to_string(setup.threads) + " " + std::to_string(setup.ttSize)
                             + " " + std::to_string(desiredTimeS);
 
+    // With a depth, every position is searched to that depth instead, which measures
+    // time-to-depth, e.g. to compare builds at a fixed hash size.
+    if (is >> setup.depth && setup.depth > 0)
+    {
+        setup.originalInvocation += " " + std::to_string(setup.depth);
+        setup.filledInvocation += " " + std::to_string(setup.depth);
+    }
+    else
+        setup.depth = 0;
+
     auto getCorrectedTime = [&](int ply) {
         // time per move is fit roughly based on LTC games
         // seconds = 50/{ply+15}
@@ -497,7 +509,9 @@ BenchmarkSetup setup_benchmark(std::istream& is) {
         {
             setup.commands.emplace_back("position fen " + fen);
             const int correctedTime = static_cast<int>(getCorrectedTime(ply++) * timeScaleFactor);
-            setup.commands.emplace_back("go movetime " + std::to_string(correctedTime));
+            setup.commands.emplace_back(
+              setup.depth ? "go depth " + std::to_string(setup.depth)
+                          : "go movetime " + std::to_string(correctedTime));
         }
     }
 
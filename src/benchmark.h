@@ -30,6 +30,7 @@ std::vector<std::string> setup_bench(const std::string&, std::istream&);
 struct BenchmarkSetup {
     int                      ttSize;
     int                      threads;
+    int                      depth;  // Fixed search depth, 0 for time based searches
     std::vector<std::string> commands;
     std::string              originalInvocation;
     std::string              filledInvocation;
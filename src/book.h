@@ -0,0 +1,78 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOK_H_INCLUDED
+#define BOOK_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+
+// An opening book in the Polyglot format. The file is a sequence of 16 byte big endian
+// entries sorted by key:
+//
+//   u64  Polyglot key of the position, see polyglot_key()
+//   u16  move, bits 0-5 the destination and 6-11 the origin square (a1 = 0), bits 12-14
+//        the promotion piece (1 knight to 4 queen). Castling is king takes own rook.
+//   u16  weight
+//   u32  learn, unused
+//
+// The file is mapped read-only, so that the threads and processes using the same book
+// share its pages.
+class Book {
+   public:
+    explicit Book(const std::string& file);
+    ~Book();
+
+    Book(const Book&)            = delete;
+    Book& operator=(const Book&) = delete;
+
+    bool  is_open() const { return data != nullptr; }
+    usize size() const { return count; }
+
+    // A legal book move of the position chosen at random by weight, none if the
+    // position is not in the book.
+    Move probe(const Position& pos) const;
+
+    // The key of the position with the random numbers of Polyglot, which is computed
+    // like Position::key(), but from scratch as only the root is probed.
+    static Key polyglot_key(const Position& pos);
+
+   private:
+    struct Entry {
+        Key key;
+        u16 move;
+        u16 weight;
+    };
+
+    Entry entry(usize idx) const;
+
+    const u8*       data   = nullptr;
+    usize           count  = 0;
+    usize           mapped = 0;  // Bytes of the mapping, 0 if the file was read instead
+    std::vector<u8> buffer;
+};
+
+}  // namespace Stockfish
+
+#endif  // #ifndef BOOK_H_INCLUDED
@@ -0,0 +1,159 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "datagen.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "bitboard.h"
+#include "position.h"
+#include "score.h"
+
+namespace Stockfish::DataGen {
+
+namespace {
+
+template<typename T>
+void put(std::string& buffer, T value) {
+    for (usize i = 0; i < sizeof(T); ++i)
+        buffer += char(u64(value) >> (8 * i));
+}
+
+}  // namespace
+
+i16 packed_score(const Score& score) {
+    if (score.is<Score::Mate>())
+    {
+        const int plies = score.get<Score::Mate>().plies;
+        return i16(plies > 0 ? 32000 - plies : -32000 - plies);
+    }
+
+    if (score.is<Score::Tablebase>())
+    {
+        const auto tb = score.get<Score::Tablebase>();
+        return i16(tb.win ? 31000 - tb.plies : -31000 - tb.plies);
+    }
+
+    return i16(std::clamp(score.get<Score::InternalUnits>().value, -30000, 30000));
+}
+
+void GameRecord::start(const Position& pos) {
+    const Bitboard occupied = pos.pieces();
+
+    startPos.clear();
+    entries.clear();
+
+    put(startPos, u64(occupied));
+
+    u8  nibbles = 0;
+    int count   = 0;
+
+    for (Bitboard b = occupied; b;)
+    {
+        const Piece pc = pos.piece_on(pop_lsb(b));
+
+        nibbles |= u8(pc) << (4 * (count++ & 1));
+
+        if (!(count & 1))
+        {
+            put(startPos, nibbles);
+            nibbles = 0;
+        }
+    }
+
+    if (count & 1)
+        put(startPos, nibbles);
+
+    const u8 flags = u8(pos.side_to_move() == BLACK) | u8(pos.can_castle(WHITE_OO)) << 1
+                   | u8(pos.can_castle(WHITE_OOO)) << 2 | u8(pos.can_castle(BLACK_OO)) << 3
+                   | u8(pos.can_castle(BLACK_OOO)) << 4;
+
+    put(startPos, flags);
+    put(startPos, u8(pos.ep_square() == SQ_NONE ? 64 : pos.ep_square()));
+    put(startPos, u8(pos.rule50_count()));
+    put(startPos, u16(1 + (pos.game_ply() - (pos.side_to_move() == BLACK)) / 2));
+}
+
+void GameRecord::add(Move move, i16 score) {
+    entries.push_back(u32(move.raw()) | u32(u16(score)) << 16);
+}
+
+void GameRecord::finish(Result result, std::string& buffer) const {
+    buffer += startPos;
+
+    put(buffer, u8(result));
+    put(buffer, u16(entries.size()));
+
+    for (u32 e : entries)
+        put(buffer, e);
+}
+
+AsyncWriter::AsyncWriter(const std::string& file) :
+    out(file, std::ios::binary) {
+
+    if (out.is_open())
+        thread = std::thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+
+    cv.notify_one();
+
+    if (thread.joinable())
+        thread.join();
+}
+
+void AsyncWriter::write(std::string&& buffer) {
+    if (buffer.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(buffer));
+    }
+
+    cv.notify_one();
+}
+
+void AsyncWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        cv.wait(lock, [this] { return done || !queue.empty(); });
+
+        if (queue.empty())
+            break;
+
+        std::string buffer = std::move(queue.front());
+        queue.pop_front();
+
+        lock.unlock();
+        out.write(buffer.data(), std::streamsize(buffer.size()));
+        lock.lock();
+    }
+
+    out.flush();
+}
+
+}  // namespace Stockfish::DataGen
@@ -0,0 +1,126 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DATAGEN_H_INCLUDED
+#define DATAGEN_H_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "misc.h"
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+class Score;
+
+// Training data generation with self-play games, see Engine::gensfen().
+//
+// Games are written in a packed format in the spirit of binpacks: the first position of
+// each game is stored in full, the later ones only as the move that leads to them. All
+// numbers are little endian, a file is just a sequence of games, so files can be joined
+// with cat. A game is
+//
+//   u64  occupied squares, a1 = bit 0
+//   u4[] the pieces of the occupied squares in square order, low nibble first, padded to a
+//        whole byte, with the Piece encoding (1-6 white pawn to king, 9-14 black)
+//   u8   bit 0 side to move (1 for black), bits 1-4 castling rights in the order
+//        white short, white long, black short, black long
+//   u8   en passant square, 64 if none
+//   u8   halfmove clock
+//   u16  fullmove number
+//   u8   result for white, 0 loss, 1 draw, 2 win
+//   u16  number of positions
+//   then for each position, the first being the one above:
+//   u16  the move played, in the 16 bit encoding of Move (see libstockfish.h)
+//   i16  the score of the search for the side to move in centipawns, or 32000 minus the
+//        plies to mate (31000 for a tablebase win), negative when losing
+namespace DataGen {
+
+struct Config {
+    std::string file;
+    u64         positions   = 1000000;  // Stop after this many positions
+    u64         nodes       = 5000;     // Nodes per move
+    int         randomPlies = 8;        // Random moves to start each game
+    int         maxPly      = 400;      // Games are draws after this many plies
+    int         evalLimit   = 3000;     // Games are adjudicated at this score (cp)
+};
+
+struct Progress {
+    u64       games;
+    u64       positions;
+    TimePoint elapsed;
+};
+
+enum Result : u8 {
+    BLACK_WINS,
+    DRAWN,
+    WHITE_WINS
+};
+
+// Stores a score of the search in the format of the file
+i16 packed_score(const Score& score);
+
+// A game of the generating thread, appended to its buffer when it is over
+class GameRecord {
+   public:
+    void  start(const Position& pos);
+    void  add(Move move, i16 score);
+    usize size() const { return entries.size(); }
+    void  finish(Result result, std::string& buffer) const;
+
+   private:
+    std::string      startPos;
+    std::vector<u32> entries;
+};
+
+// Writes the buffers of the generating threads on a thread of its own, so that
+// they do not wait for the disk.
+class AsyncWriter {
+   public:
+    explicit AsyncWriter(const std::string& file);
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter&)            = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    bool is_open() const { return out.is_open(); }
+    void write(std::string&& buffer);
+
+   private:
+    void run();
+
+    std::ofstream           out;
+    std::mutex              mutex;
+    std::condition_variable cv;
+    std::deque<std::string> queue;
+    bool                    done = false;
+    std::thread             thread;
+};
+
+}  // namespace DataGen
+
+}  // namespace Stockfish
+
+#endif  // #ifndef DATAGEN_H_INCLUDED
@@ -19,24 +19,33 @@
 #include "engine.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
 #include <deque>
+#include <fstream>
 #include <iosfwd>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <sstream>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "book.h"
+#include "datagen.h"
 #include "evaluate.h"
 #include "misc.h"
+#include "movegen.h"
 #include "nnue/network.h"
+#include "nnue/nnue_accumulator.h"
 #include "nnue/nnue_common.h"
 #include "nnue/nnue_misc.h"
 #include "numa.h"
 #include "perft.h"
 #include "position.h"
+#include "score.h"
 #include "search.h"
 #include "shm.h"
 #include "syzygy/tbprobe.h"
@@ -59,12 +68,35 @@ constexpr NumaAutoPolicy DefaultNumaPolicy = BundledL3Policy{32};
 
 Engine::Engine(std::optional<std::string> path) :
     binaryDirectory(path ? CommandLine::get_binary_directory(*path) : ""),
-    numaContext(NumaConfig::from_system(DefaultNumaPolicy)),
+    ownNumaContext(
+      std::make_unique<NumaReplicationContext>(NumaConfig::from_system(DefaultNumaPolicy))),
+    ownNetwork(std::make_unique<NumaReplicatedPublisher<NN::Network>>(
+      std::make_unique<LazyNumaReplicatedSystemWide<NN::Network>>(*ownNumaContext,
+                                                                  get_default_network()))),
+    numaContext(*ownNumaContext),
     states(new std::deque<StateInfo>(1)),
     threads(),
-    network(numaContext, get_default_network()) {
+    network(*ownNetwork) {
+
+    startup_step("Network replication");
+    init();
+}
+
+Engine::Engine(Engine& hostEngine) :
+    binaryDirectory(hostEngine.binaryDirectory),
+    host(&hostEngine),
+    numaContext(hostEngine.numaContext),
+    states(new std::deque<StateInfo>(1)),
+    threads(),
+    network(hostEngine.network) {
+
+    init();
+}
+
+void Engine::init() {
 
     pos.set(StartFEN, false, &states->back());
+    positionFen = StartFEN;
 
     options.add(  //
       "Debug Log File", Option("", [](const Option& o) {
@@ -73,16 +105,24 @@ Engine::Engine(std::optional<std::string> path) :
       }));
 
     options.add(  //
-      "NumaPolicy", Option("auto", [this](const Option& o) {
+      "NumaPolicy", Option("auto", [this](const Option& o) -> std::optional<std::string> {
+          if (host)
+              return keep_host_option("NumaPolicy");
+
           set_numa_config_from_option(o);
           return numa_config_information_as_string() + "\n"
                + thread_allocation_information_as_string();
       }));
 
     options.add(  //
-      "Threads", Option(1, 1, MaxThreads, [this](const Option&) {
+      "Threads", Option(1, 1, MaxThreads, [this](const Option&) -> std::optional<std::string> {
+          // For a session of the server, the maximum number of threads of its searches
+          if (host)
+              return std::nullopt;
+
           resize_threads();
-          return thread_allocation_information_as_string();
+          return thread_allocation_information_as_string() + ", set up in "
+               + std::to_string(threads.setup_time()) + " ms";
       }));
 
     options.add(  //
@@ -91,6 +131,40 @@ Engine::Engine(std::optional<std::string> path) :
           return std::nullopt;
       }));
 
+    options.add(  //
+      "SharedHash", Option("", [this](const Option& o) -> std::optional<std::string> {
+          tt.set_shared_name(o);
+          set_tt_size(options["Hash"]);
+
+          if (std::string(o).empty())
+              return std::nullopt;
+
+          if (!tt.is_shared())
+              return "Shared hash unavailable, using private memory";
+
+          return "Shared hash " + std::string(o) + " attached by "
+               + std::to_string(tt.shared_ref_count()) + " process(es)";
+      }));
+
+    options.add(  //
+      "NumaPartitionedHash", Option(false, [this](const Option& o) -> std::optional<std::string> {
+          tt.set_numa_partitioned(o);
+          set_tt_size(options["Hash"]);
+
+          if (tt.is_numa_partitioned())
+              return "Hash partitioned over " + std::to_string(tt.partition_count())
+                   + " NUMA nodes";
+
+          if (o)
+              return "Hash partitioning needs threads bound to several NUMA nodes";
+
+          return std::nullopt;
+      }));
+
+    // Per thread, in MiB, 0 to disable it. See Eval::NNUE::EvalCache.
+    options.add(  //
+      "EvalCache", Option(0, 0, 1024));
+
     options.add(  //
       "Clear Hash", Option([this](const Option&) {
           search_clear();
@@ -119,8 +193,17 @@ Engine::Engine(std::optional<std::string> path) :
 
     options.add("UCI_ShowWDL", Option(false));
 
+    options.add("MateHash", Option(16, 0, MaxHashMB));
+
+    options.add("UCI_OutputFormat", Option("text var text var json var binary", "text"));
+
+    options.add("InfoInterval", Option(0, 0, 10000));
+
     options.add(  //
-      "SyzygyPath", Option("", [](const Option& o) {
+      "SyzygyPath", Option("", [this](const Option& o) -> std::optional<std::string> {
+          if (host)
+              return keep_host_option("SyzygyPath");
+
           Tablebases::init(o);
           return std::nullopt;
       }));
@@ -132,26 +215,414 @@ Engine::Engine(std::optional<std::string> path) :
     options.add("SyzygyProbeLimit", Option(7, 0, 7));
 
     options.add(  //
-      "EvalFile", Option(EvalFileDefaultName, [this](const Option& o) {
+      "BookFile", Option("", [this](const Option& o) -> std::optional<std::string> {
+          book.reset();
+
+          if (std::string(o).empty())
+              return std::nullopt;
+
+          auto newBook = std::make_shared<const Book>(o);
+
+          if (!newBook->is_open())
+              return "Unable to open book " + std::string(o);
+
+          book = std::move(newBook);
+          return "Book " + std::string(o) + " with " + std::to_string(book->size())
+               + " entries";
+      }));
+
+    options.add(  //
+      "EvalFile",
+      Option(EvalFileDefaultName, [this](const Option& o) -> std::optional<std::string> {
+          if (host)
+              return keep_host_option("EvalFile");
+
           load_network(o);
           return std::nullopt;
       }));
 
+    // Sessions start with the book of the host, but can choose their own
+    if (host)
+    {
+        for (const auto& name : {"NumaPolicy", "SyzygyPath", "EvalFile", "BookFile"})
+            options.options_map[name].currentValue = host->options.options_map[name].currentValue;
+
+        book = host->book;
+    }
+
+    startup_step("Options");
+
     threads.clear();
     threads.ensure_network_replicated();
     resize_threads();
+    startup_step("Threads and hash");
 }
 
 u64 Engine::perft(const std::string& fen, Depth depth, bool isChess960) {
     verify_network();
+    wait_for_search_finished();
+    tt.stop_scrub(threads);
+
+    // Perfts below depth 3 use no hash, deeper ones use the memory of the transposition
+    // table if it can be lent, see TranspositionTable::lend()
+    const usize lendable = depth >= 3 ? tt.lendable_bytes() : 0;
+    void*       mem      = lendable ? tt.lend(threads) : nullptr;
+    const usize bytes    = mem ? lendable : usize(options["Hash"]) * 1024 * 1024;
+
+    const u64 nodes = Benchmark::perft(fen, depth, isChess960, threads, bytes, mem);
+
+    tt.reclaim(threads);
+    return nodes;
+}
+
+bool Engine::perft_suite(const std::string& file) {
+    verify_network();
+    wait_for_search_finished();
+    tt.stop_scrub(threads);
+
+    const usize lendable = tt.lendable_bytes();
+    void*       mem      = lendable ? tt.lend(threads) : nullptr;
+    const usize bytes    = mem ? lendable : usize(options["Hash"]) * 1024 * 1024;
+
+    const bool passed = Benchmark::perft_suite(file, options["UCI_Chess960"], threads, bytes, mem);
+
+    tt.reclaim(threads);
+    return passed;
+}
+
+// Reads the positions of an EPD file, i.e. the four FEN fields followed by operations.
+// Lines with full FENs are accepted as well.
+static std::string epd_to_fen(const std::string& line) {
+    std::istringstream is(line);
+    std::string        fen, token;
+
+    for (int field = 0; field < 6 && is >> token; ++field)
+    {
+        if (field >= 4 && token.find_first_not_of("0123456789") != std::string::npos)
+            break;
+
+        fen += token + " ";
+    }
+
+    return fen;
+}
+
+std::optional<std::string> Engine::analyse(const std::string&                       file,
+                                           const Search::LimitsType&                limits,
+                                           std::function<void(const InfoAnalysis&)> onResult) {
+    wait_for_search_finished();
+    verify_network();
+
+    std::ifstream stream(file);
+    if (!stream)
+        return "Unable to open file " + file;
+
+    // Check all positions first, so that a broken file does not waste any search
+    std::vector<std::string> fens;
+    StateInfo                st;
+    Position                 p;
+    usize                    lineNumber = 0;
+
+    for (std::string line; std::getline(stream, line);)
+    {
+        ++lineNumber;
+
+        const std::string fen = epd_to_fen(line);
+        if (fen.empty() || fen[0] == '#')
+            continue;
+
+        if (auto err = p.set(fen, options["UCI_Chess960"], &st))
+            return "Invalid position on line " + std::to_string(lineNumber) + ": " + err->what();
+
+        fens.push_back(fen);
+    }
+
+    const usize               slotCount = prepare_search_slots(fens.size());
+    std::vector<InfoAnalysis> results(slotCount);
+
+    for (usize i = 0; i < slotCount; ++i)
+    {
+        InfoAnalysis& result = results[i];
+        auto&         update = searchSlots[i]->updateContext;
+
+        update.onUpdateNoMoves = [&result](const InfoShort& info) {
+            result.depth = info.depth;
+            result.score = info.score;
+        };
+        update.onUpdateFull = [&result](const InfoFull& info) {
+            if (info.multiPV != 1)
+                return;
+
+            result.depth    = info.depth;
+            result.score    = info.score;
+            result.selDepth = info.selDepth;
+            result.timeMs   = info.timeMs;
+            result.nodes    = info.nodes;
+            result.pv       = UCIEngine::format_pv(*info.pv, info.chess960);
+        };
+        update.onBestmove = [&result](std::string_view bestmove, std::string_view) {
+            result.bestmove = bestmove;
+        };
+    }
+
+    std::atomic<usize> next = 0;
+
+    tt.stop_scrub(threads);
+
+    for (usize i = 0; i < slotCount; ++i)
+        threads.run_on_thread(i, [&, i]() {
+            SearchSlot&   slot   = *searchSlots[i];
+            InfoAnalysis& result = results[i];
+
+            for (usize n; (n = next++) < fens.size();)
+            {
+                StateListPtr       slotStates(new std::deque<StateInfo>(1));
+                Position           slotPos;
+                Search::LimitsType slotLimits = limits;
+
+                slotPos.set(fens[n], options["UCI_Chess960"], &slotStates->back());
+                slotLimits.startTime = now();
+
+                result       = InfoAnalysis{};
+                result.index = n + 1;
 
-    return Benchmark::perft(fen, depth, isChess960);
+                slot.threads.start_thinking(options, slotPos, slotStates, slotLimits);
+                slot.threads.main_thread()->wait_for_search_finished();
+
+                onResult(result);
+            }
+        });
+
+    for (usize i = 0; i < slotCount; ++i)
+        threads.wait_on_thread(i);
+
+    tt.reclaim(threads);
+    return std::nullopt;
+}
+
+std::optional<std::string>
+Engine::gensfen(const DataGen::Config&                        config,
+                std::function<void(const DataGen::Progress&)> onProgress) {
+    wait_for_search_finished();
+    verify_network();
+
+    DataGen::AsyncWriter writer(config.file);
+    if (!writer.is_open())
+        return "Unable to open file " + config.file;
+
+    const usize slotCount = prepare_search_slots(threads.num_threads());
+
+    // The result of each search is the score and move of the root
+    struct SearchResult {
+        Score       score;
+        std::string bestmove;
+    };
+
+    std::vector<SearchResult> results(slotCount);
+
+    for (usize i = 0; i < slotCount; ++i)
+    {
+        SearchResult& result = results[i];
+        auto&         update = searchSlots[i]->updateContext;
+
+        update.onUpdateNoMoves = [&result](const InfoShort& info) { result.score = info.score; };
+        update.onUpdateFull    = [&result](const InfoFull& info) {
+            if (info.multiPV == 1)
+                result.score = info.score;
+        };
+        update.onBestmove = [&result](std::string_view bestmove, std::string_view) {
+            result.bestmove = bestmove;
+        };
+    }
+
+    std::atomic<u64> positions = 0, games = 0;
+    std::mutex       progressMutex;
+    const TimePoint  start = now();
+
+    tt.stop_scrub(threads);
+
+    for (usize i = 0; i < slotCount; ++i)
+        threads.run_on_thread(i, [&, i]() {
+            SearchSlot&         slot   = *searchSlots[i];
+            SearchResult&       result = results[i];
+            PRNG                rng(u64(now()) * 6364136223846793005ULL + i + 1);
+            DataGen::GameRecord game;
+            std::string         buffer;
+
+            Search::LimitsType limits;
+            limits.nodes = config.nodes;
+
+            while (positions < config.positions)
+            {
+                StateListPtr gameStates(new std::deque<StateInfo>(1));
+                Position     gamePos;
+
+                gamePos.set(StartFEN, false, &gameStates->back());
+
+                // The random moves are not part of the game record
+                for (int ply = 0; ply < config.randomPlies; ++ply)
+                {
+                    const MoveList<LEGAL> moves(gamePos);
+                    if (!moves.size())
+                        break;
+
+                    gameStates->emplace_back();
+                    gamePos.do_move(moves.begin()[rng.rand<u64>() % moves.size()],
+                                    gameStates->back());
+                }
+
+                if (!MoveList<LEGAL>(gamePos).size())
+                    continue;
+
+                // Each game starts with an empty table and histories, so that the positions
+                // of a game do not depend on the games the slot played before
+                slot.threads.clear();
+                slot.tt.clear(slot.threads);
+
+                game.start(gamePos);
+
+                DataGen::Result gameResult = DataGen::DRAWN;
+
+                for (int ply = 0;; ++ply)
+                {
+                    const Color us = gamePos.side_to_move();
+
+                    if (!MoveList<LEGAL>(gamePos).size())
+                    {
+                        if (gamePos.checkers())
+                            gameResult = us == WHITE ? DataGen::BLACK_WINS : DataGen::WHITE_WINS;
+                        break;
+                    }
+
+                    // Repetitions and the 50 move rule end the game as a draw
+                    if (ply >= config.maxPly || gamePos.is_draw(ply))
+                        break;
+
+                    limits.startTime = now();
+
+                    slot.threads.start_thinking(options, gamePos, gameStates, limits);
+                    slot.threads.main_thread()->wait_for_search_finished();
+
+                    // The states of the game, which are needed for the repetitions
+                    gameStates = slot.threads.take_setup_states();
+
+                    const Move m     = UCIEngine::to_move(gamePos, result.bestmove);
+                    const i16  score = DataGen::packed_score(result.score);
+
+                    game.add(m, score);
+
+                    if (std::abs(score) >= config.evalLimit)
+                    {
+                        gameResult = (score > 0) == (us == WHITE) ? DataGen::WHITE_WINS
+                                                                   : DataGen::BLACK_WINS;
+                        break;
+                    }
+
+                    gameStates->emplace_back();
+                    gamePos.do_move(m, gameStates->back());
+                }
+
+                game.finish(gameResult, buffer);
+
+                positions += game.size();
+                ++games;
+
+                if (buffer.size() >= 1024 * 1024)
+                {
+                    writer.write(std::move(buffer));
+                    buffer.clear();
+                }
+
+                std::lock_guard<std::mutex> lock(progressMutex);
+                onProgress({games, positions, now() - start});
+            }
+
+            writer.write(std::move(buffer));
+        });
+
+    for (usize i = 0; i < slotCount; ++i)
+        threads.wait_on_thread(i);
+
+    tt.reclaim(threads);
+    return std::nullopt;
+}
+
+usize Engine::prepare_search_slots(usize count) {
+
+    const usize slotCount = std::min(threads.num_threads(), count);
+    const usize ttSize    = std::max(usize(options["Hash"]) / std::max(slotCount, usize(1)),
+                                     usize(1));
+
+    // The slots split the memory of the engine's table into cache line aligned parts, unless
+    // that leaves them less than the minimum Hash of 1 MiB each. Callers give the memory back
+    // with tt.reclaim().
+    const usize slotBytes = tt.lendable_bytes() / std::max(slotCount, usize(1)) / 64 * 64;
+
+    char* lent = slotBytes >= 1024 * 1024 ? static_cast<char*>(tt.lend(threads)) : nullptr;
+
+    // Slots left by an earlier call are reused, the missing ones are set up with one thread
+    // each, bound like the engine's thread which drives them.
+    const std::vector<NumaIndex> binding       = threads.get_bound_thread_to_numa_node();
+    auto&                        threadsOption = options.options_map["Threads"];
+    const std::string            value         = threadsOption.currentValue;
+
+    threadsOption.currentValue = "1";
+
+    while (searchSlots.size() < slotCount)
+    {
+        const usize i    = searchSlots.size();
+        SearchSlot& slot = *searchSlots.emplace_back(std::make_unique<SearchSlot>());
+
+        slot.threads.set(numaContext.get_numa_config(),
+                         {options, slot.threads, slot.tt, slot.sharedHists, network},
+                         slot.updateContext,
+                         binding.empty() ? std::nullopt : std::optional<NumaIndex>(binding[i]));
+    }
+
+    threadsOption.currentValue = value;
+
+    for (usize i = 0; i < slotCount; ++i)
+    {
+        SearchSlot& slot = *searchSlots[i];
+
+        slot.updateContext.onUpdateNoMoves = [](const InfoShort&) {};
+        slot.updateContext.onUpdateFull    = [](const InfoFull&) {};
+        slot.updateContext.onIter          = [](const InfoIter&) {};
+        slot.updateContext.onBestmove      = [](std::string_view, std::string_view) {};
+
+        slot.threads.ensure_network_replicated();
+        slot.threads.clear();
+
+        if (lent)
+            slot.tt.attach(lent + i * slotBytes, slotBytes, slot.threads);
+        else
+            slot.tt.resize(ttSize, slot.threads);
+    }
+
+    return slotCount;
 }
 
 void Engine::go(Search::LimitsType& limits) {
     assert(limits.perft == 0);
+    wait_for_search_finished();
     verify_network();
 
+    // Frees a network replaced during the last search, which its workers have left
+    network.collect();
+
+    // A book move is played right away, unless the search is not meant to end by itself
+    if (book && !limits.infinite && !limits.ponderMode && !limits.mate)
+        if (const Move m = book->probe(pos);
+            m != Move::none()
+            && (limits.searchmoves.empty()
+                || std::count(limits.searchmoves.begin(), limits.searchmoves.end(),
+                              UCIEngine::move(m, pos.is_chess960()))))
+        {
+            updateContext.onBestmove(UCIEngine::move(m, pos.is_chess960()), "");
+            return;
+        }
+
+    tt.stop_scrub(threads);
     threads.start_thinking(options, pos, states, limits);
 }
 void Engine::stop() { threads.stop = true; }
@@ -159,11 +630,13 @@ void Engine::stop() { threads.stop = true; }
 void Engine::search_clear() {
     wait_for_search_finished();
 
-    tt.clear(threads);
+    // The TT is cleared lazily, so that the threads are free to reset it in the background
     threads.clear();
+    tt.clear_lazily(threads);
 
     // @TODO wont work with multiple instances
-    Tablebases::init(options["SyzygyPath"]);  // Free mapped files
+    if (!host)
+        Tablebases::init(options["SyzygyPath"]);  // Free mapped files
 }
 
 void Engine::set_on_update_no_moves(std::function<void(const Engine::InfoShort&)>&& f) {
@@ -182,29 +655,68 @@ void Engine::set_on_bestmove(std::function<void(std::string_view, std::string_vi
     updateContext.onBestmove = std::move(f);
 }
 
+void Engine::set_on_tick(std::function<void()>&& f) { updateContext.onTick = std::move(f); }
+
 void Engine::set_on_verify_network(std::function<void(std::string_view)>&& f) {
     onVerifyNetwork = std::move(f);
 }
 
-void Engine::wait_for_search_finished() { threads.main_thread()->wait_for_search_finished(); }
+void Engine::wait_for_search_finished() {
+    if (threads.num_threads())
+        threads.main_thread()->wait_for_search_finished();
+
+    if (networkLoader.joinable())
+        networkLoader.join();
+
+    // The workers are done with the options, so the network loaded meanwhile can be set
+    if (pendingEvalFile)
+    {
+        options.options_map["EvalFile"].currentValue = *pendingEvalFile;
+        pendingEvalFile.reset();
+    }
+}
 
 std::optional<PositionSetError> Engine::set_position(const std::string&              fen,
                                                      const std::vector<std::string>& moves) {
-    // Drop the old state and create a new one
-    states   = StateListPtr(new std::deque<StateInfo>(1));
-    auto err = pos.set(fen, options["UCI_Chess960"], &states->back());
-    if (err.has_value())
-        return err;
+    const bool chess960 = options["UCI_Chess960"];
 
-    for (const auto& move : moves)
+    if (fen == positionFen && chess960 == positionChess960
+        && moves.size() >= positionMoves.size()
+        && std::equal(positionMoves.begin(), positionMoves.end(), moves.begin()))
     {
-        auto m = UCIEngine::to_move(pos, move);
+        // The states were handed over to the threads by the last 'go'
+        if (!states)
+            states = threads.take_setup_states();
+
+        assert(states && &states->back() == pos.state());
+    }
+    else
+    {
+        // Drop the old state and create a new one. States taken back from the threads
+        // may still be in use by a search, so they keep them.
+        positionFen.clear();
+        positionMoves.clear();
+        threads.keep_setup_states(std::move(states));
+
+        states   = StateListPtr(new std::deque<StateInfo>(1));
+        auto err = pos.set(fen, chess960, &states->back());
+        if (err.has_value())
+            return err;
+
+        positionFen      = fen;
+        positionChess960 = chess960;
+    }
+
+    for (usize i = positionMoves.size(); i < moves.size(); ++i)
+    {
+        auto m = UCIEngine::to_move(pos, moves[i]);
 
         if (m == Move::none())
-            return PositionSetError("Illegal move: " + move);
+            return PositionSetError("Illegal move: " + moves[i]);
 
         states->emplace_back();
         pos.do_move(m, states->back());
+        positionMoves.push_back(moves[i]);
     }
 
     return std::nullopt;
@@ -226,6 +738,17 @@ void Engine::set_numa_config_from_option(const std::string& o) {
     {
         numaContext.set_numa_config(NumaConfig{});
     }
+    else if (o == "l3")
+    {
+        // A node for every L3 domain, so that no history is shared across L3 caches
+        numaContext.set_numa_config(NumaConfig::from_system(L3DomainsPolicy{}));
+    }
+    else if (o.rfind("l3:", 0) == 0)
+    {
+        // L3 domains bundled up to the given number of processors
+        numaContext.set_numa_config(
+          NumaConfig::from_system(BundledL3Policy{str_to_size_t(o.substr(3))}));
+    }
     else
     {
         numaContext.set_numa_config(NumaConfig::from_string(o));
@@ -238,27 +761,89 @@ void Engine::set_numa_config_from_option(const std::string& o) {
 
 void Engine::resize_threads() {
     threads.wait_for_search_finished();
+    tt.stop_scrub(threads);
+    searchSlots.clear();
+
+    const bool recreated = threads.set(numaContext.get_numa_config(),
+                                       {options, threads, tt, sharedHists, network}, updateContext);
+
+    // Reallocate the hash with the new threadpool size. If only the number of threads
+    // changed, the hash stays as it is, unless it is partitioned by their nodes.
+    if (recreated || tt.is_numa_partitioned())
+        set_tt_size(options["Hash"]);
+
+    threads.ensure_network_replicated();
+}
+
+void Engine::set_search_threads(usize count) {
+    wait_for_search_finished();
+    tt.stop_scrub(threads);
+    searchSlots.clear();
+
+    // The threads are set up from the option, which then gets its value back
+    auto&             threadsOption = options.options_map["Threads"];
+    const std::string value         = threadsOption.currentValue;
+
+    threadsOption.currentValue = std::to_string(count);
     threads.set(numaContext.get_numa_config(), {options, threads, tt, sharedHists, network},
                 updateContext);
+    threadsOption.currentValue = value;
 
-    // Reallocate the hash with the new threadpool size
-    set_tt_size(options["Hash"]);
     threads.ensure_network_replicated();
 }
 
+void Engine::set_session_threads_default(usize count) {
+    assert(host);
+
+    auto& threadsOption        = options.options_map["Threads"];
+    threadsOption.defaultValue = threadsOption.currentValue = std::to_string(count);
+}
+
+usize Engine::search_threads() const { return threads.num_threads(); }
+
+// Options of a session which belong to the host engine are restored to the host's value
+std::optional<std::string> Engine::keep_host_option(const std::string& name) {
+    options.options_map[name].currentValue = host->options.options_map[name].currentValue;
+
+    return name + " is shared by all sessions of the server and was not changed";
+}
+
 void Engine::set_tt_size(usize mb) {
     wait_for_search_finished();
-    tt.resize(mb, threads);
+    tt.rehash(mb, threads);
+}
+
+void Engine::save_tt(const std::string& file) {
+    wait_for_search_finished();
+    tt.stop_scrub(threads);
+
+    sync_cout << (tt.save(file) ? "Hash saved successfully to " + file : "Failed to save hash")
+              << sync_endl;
+}
+
+// The loaded table keeps the size it was saved with, until the next
+// change of the Hash or Threads options reallocates it.
+void Engine::load_tt(const std::string& file, bool shared) {
+    wait_for_search_finished();
+    tt.stop_scrub(threads);
+
+    if (tt.load(file, shared))
+        sync_cout << "Hash loaded successfully from " << file << " (" << tt.size_mb() << " MiB)"
+                  << sync_endl;
+    else
+        sync_cout << "Failed to load hash from " << file << sync_endl;
 }
 
 void Engine::set_ponderhit(bool b) { threads.main_manager()->ponder = b; }
 
 // network related
 
+bool Engine::network_loaded() const { return (*network)->is_loaded(options["EvalFile"]); }
+
 void Engine::verify_network() const {
-    network->verify(options["EvalFile"], onVerifyNetwork);
+    (*network)->verify(options["EvalFile"], onVerifyNetwork);
 
-    auto statuses = network.get_status_and_errors();
+    auto statuses = network->get_status_and_errors();
     for (usize i = 0; i < statuses.size(); ++i)
     {
         const auto [status, error] = statuses[i];
@@ -275,6 +860,10 @@ void Engine::verify_network() const {
         {
             message += "Shared memory.";
         }
+        else if (status == SystemWideSharedConstantAllocationStatus::MappedFile)
+        {
+            message += "Mapped from file.";
+        }
         else
         {
             message += "Unknown status.";
@@ -291,22 +880,74 @@ void Engine::verify_network() const {
 
 std::unique_ptr<Eval::NNUE::Network> Engine::get_default_network() const {
 
+    // Called first by the constructor, after the NUMA configuration
+    startup_step("NUMA configuration");
+
     auto network_ = std::make_unique<NN::Network>(NN::EvalFile{EvalFileDefaultName, "None", ""});
 
     network_->load(binaryDirectory, "");
+    startup_step("Default network");
 
     return network_;
 }
 
+std::shared_ptr<LazyNumaReplicatedSystemWide<NN::Network>>
+Engine::read_network(const NN::Network& current, const std::string& file) const {
+    using Replicas = LazyNumaReplicatedSystemWide<NN::Network>;
+
+    // A network in the mapped format is used in place, without any copy
+    if (auto mapped = current.map(binaryDirectory, file))
+        return std::make_shared<Replicas>(numaContext, std::move(mapped));
+
+    auto network_ = std::make_unique<NN::Network>(current);
+    network_->load(binaryDirectory, file);
+    return std::make_shared<Replicas>(numaContext, std::move(network_));
+}
+
 void Engine::load_network(const std::string& file) {
-    network.modify_and_replicate(
-      [this, &file](NN::Network& network_) { network_.load(binaryDirectory, file); });
+    network.publish(read_network(**network, file));
+
     threads.clear();
     threads.ensure_network_replicated();
+    network.collect();
+}
+
+bool Engine::load_network_while_searching(const std::string& file) {
+    if (!threads.searching())
+        return false;
+
+    if (networkLoader.joinable())
+        networkLoader.join();
+
+    // The loader is the only thread publishing, and the NUMA context is not changed
+    // meanwhile, since all other changes wait for the loader first. A network read only
+    // partially is not used, its weights may be anything.
+    networkLoader = std::thread([this, file]() {
+        const auto current  = network.get();
+        auto       replicas = read_network(**current, file);
+
+        if (!(*replicas)->is_loaded(file))
+        {
+            sync_cout << "info string ERROR: The network file " << file
+                      << " was not loaded successfully, the current network is kept"
+                      << sync_endl;
+            return;
+        }
+
+        replicas->replicate_all();
+        network.publish(std::move(replicas));
+        pendingEvalFile = file;
+    });
+
+    return true;
 }
 
-void Engine::save_network(const std::pair<std::optional<std::string>, std::string> file) {
-    network.modify_and_replicate([&file](NN::Network& network_) { network_.save(file.first); });
+void Engine::save_network(const std::pair<std::optional<std::string>, std::string> file,
+                          bool mapped) {
+    if (mapped)
+        (*network)->save_mapped(file.second);
+    else
+        (*network)->save(file.first);
 }
 
 // utility functions
@@ -318,7 +959,33 @@ void Engine::trace_eval() const {
 
     verify_network();
 
-    sync_cout << "\n" << Eval::trace(p, *network) << sync_endl;
+    sync_cout << "\n" << Eval::trace(p, **network) << sync_endl;
+}
+
+std::optional<std::string> Engine::evaluate_batch(const std::vector<std::string>& fens,
+                                                  std::vector<Value>&             results) const {
+    std::vector<StateInfo>       batchStates(fens.size());
+    std::vector<Position>        positions(fens.size());
+    std::vector<const Position*> pointers;
+
+    for (usize i = 0; i < fens.size(); ++i)
+    {
+        if (auto err = positions[i].set(fens[i], options["UCI_Chess960"], &batchStates[i]))
+            return "Invalid position " + fens[i] + ": " + err->what();
+
+        pointers.push_back(&positions[i]);
+    }
+
+    verify_network();
+
+    auto accumulators = std::make_unique<Eval::NNUE::AccumulatorStack>();
+    auto caches       = std::make_unique<Eval::NNUE::AccumulatorCaches>(**network);
+
+    results.resize(fens.size());
+    Eval::evaluate_batch(**network, pointers.data(), pointers.size(), *accumulators, *caches,
+                         results.data());
+
+    return std::nullopt;
 }
 
 const OptionsMap& Engine::get_options() const { return options; }
@@ -326,7 +993,10 @@ OptionsMap&       Engine::get_options() { return options; }
 
 std::string Engine::fen() const { return pos.fen(); }
 
-void Engine::flip() { pos.flip(); }
+void Engine::flip() {
+    pos.flip();
+    positionFen.clear();
+}
 
 std::string Engine::visualize() const {
     std::stringstream ss;
@@ -336,6 +1006,13 @@ std::string Engine::visualize() const {
 
 int Engine::get_hashfull(int maxAge) const { return tt.hashfull(maxAge); }
 
+// Aggregated over all threads, for the last search
+TTStats Engine::get_tt_stats() const { return threads.tt_stats(); }
+
+Eval::NNUE::EvalCache::Stats Engine::get_eval_cache_stats() const {
+    return threads.eval_cache_stats();
+}
+
 std::vector<std::pair<usize, usize>> Engine::get_bound_thread_count_by_numa_node() const {
     auto                                 counts = threads.get_bound_thread_count_by_numa_node();
     const NumaConfig&                    cfg    = numaContext.get_numa_config();
@@ -377,6 +1054,16 @@ std::string Engine::thread_binding_information_as_string() const {
     return ss.str();
 }
 
+std::string Engine::thread_timing_information_as_string() const {
+    std::stringstream ss;
+
+    ss << "Thread setup               : " << threads.setup_time() << " ms for "
+       << threads.size() << (threads.size() > 1 ? " threads" : " thread")
+       << "\nThread clear               : " << threads.clear_time() << " ms";
+
+    return ss.str();
+}
+
 std::string Engine::thread_allocation_information_as_string() const {
     std::stringstream ss;
 
@@ -25,9 +25,11 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "datagen.h"
 #include "misc.h"
 #include "history.h"
 #include "nnue/network.h"
@@ -41,13 +43,20 @@
 
 namespace Stockfish {
 
+class Book;
+
 class Engine {
    public:
     using InfoShort = Search::InfoShort;
     using InfoFull  = Search::InfoFull;
     using InfoIter  = Search::InfoIteration;
 
+    using InfoAnalysis = Search::InfoAnalysis;
+
     Engine(std::optional<std::string> path = std::nullopt);
+    // Session of the server, sharing the NUMA context, network and tablebases of the
+    // host engine, which must outlive it. These cannot be changed by the session.
+    explicit Engine(Engine& host);
 
     // Cannot be movable due to components holding backreferences to fields
     Engine(const Engine&)            = delete;
@@ -55,9 +64,27 @@ class Engine {
     Engine& operator=(const Engine&) = delete;
     Engine& operator=(Engine&&)      = delete;
 
-    ~Engine() { wait_for_search_finished(); }
+    ~Engine() {
+        wait_for_search_finished();
+        tt.stop_scrub(threads);
+    }
+
+    u64  perft(const std::string& fen, Depth depth, bool isChess960);
+    bool perft_suite(const std::string& file);
+
+    // blocking call to search all positions of an EPD or FEN file with the given limits.
+    // Each thread searches whole positions on its own, with its own slice of the hash, and
+    // onResult is called, concurrently, as soon as a position is done. Returns an error
+    // message if the file cannot be used.
+    std::optional<std::string> analyse(const std::string&                       file,
+                                       const Search::LimitsType&                limits,
+                                       std::function<void(const InfoAnalysis&)> onResult);
 
-    u64 perft(const std::string& fen, Depth depth, bool isChess960);
+    // Plays self-play games with a fixed number of nodes per move, one per thread, until
+    // the given number of positions is reached, and writes them to a file for training.
+    // onProgress is called after every game.
+    std::optional<std::string> gensfen(const DataGen::Config&                        config,
+                                       std::function<void(const DataGen::Progress&)> onProgress);
 
     // non blocking call to start searching
     void go(Search::LimitsType&);
@@ -66,7 +93,8 @@ class Engine {
 
     // blocking call to wait for search to finish
     void wait_for_search_finished();
-    // set a new position, moves are in UCI format
+    // set a new position, moves are in UCI format. If they only extend the moves of the
+    // current position, just the new ones are played.
     std::optional<PositionSetError> set_position(const std::string&              fen,
                                                  const std::vector<std::string>& moves);
 
@@ -74,7 +102,17 @@ class Engine {
 
     void set_numa_config_from_option(const std::string& o);
     void resize_threads();
+    // Sets the number of search threads regardless of the Threads option and without
+    // reallocating the hash. With zero threads the engine can be configured, but
+    // not search or clear the hash.
+    void set_search_threads(usize count);
+    // For a session of the server, the default of its Threads option, which is the
+    // maximum number of threads of its searches
+    void set_session_threads_default(usize count);
+    usize search_threads() const;
     void set_tt_size(usize mb);
+    void save_tt(const std::string& file);
+    void load_tt(const std::string& file, bool shared);
     void set_ponderhit(bool);
     void search_clear();
 
@@ -82,23 +120,43 @@ class Engine {
     void set_on_update_full(std::function<void(const InfoFull&)>&&);
     void set_on_iter(std::function<void(const InfoIter&)>&&);
     void set_on_bestmove(std::function<void(std::string_view, std::string_view)>&&);
+    void set_on_tick(std::function<void()>&&);
     void set_on_verify_network(std::function<void(std::string_view)>&&);
 
     // network related
 
+    // Terminates the engine if the network of the EvalFile option is not loaded
     void                                 verify_network() const;
+    bool                                 network_loaded() const;
     std::unique_ptr<Eval::NNUE::Network> get_default_network() const;
+    // Must not be called while searching, see load_network_while_searching()
     void                                 load_network(const std::string& file);
-    void save_network(std::pair<std::optional<std::string>, std::string> file);
+    // If a search is running, loads the network of the EvalFile option on a thread of its
+    // own and replicates it, else returns false. The search switches to the network at
+    // its next iteration, and the option is set once the search has finished, as the
+    // workers read the options meanwhile. A network which fails to load is reported and
+    // the current one is kept.
+    bool load_network_while_searching(const std::string& file);
+    // With mapped, the network is saved in the format which load_network() maps in place,
+    // see Network::save_mapped(). It then needs a file name.
+    void save_network(std::pair<std::optional<std::string>, std::string> file,
+                      bool                                                mapped = false);
 
     // utility functions
 
     void trace_eval() const;
+    // Static evaluations of many positions, VALUE_NONE for those in check, for scoring
+    // positions offline. Returns an error message if a position is invalid.
+    std::optional<std::string> evaluate_batch(const std::vector<std::string>& fens,
+                                              std::vector<Value>&             results) const;
 
     const OptionsMap& get_options() const;
     OptionsMap&       get_options();
 
-    int get_hashfull(int maxAge = 0) const;
+    int     get_hashfull(int maxAge = 0) const;
+    TTStats get_tt_stats() const;
+    // Probes and hits of the eval caches of the threads in the last search
+    Eval::NNUE::EvalCache::Stats get_eval_cache_stats() const;
 
     std::string                          fen() const;
     void                                 flip();
@@ -107,24 +165,60 @@ class Engine {
     std::string                          get_numa_config_as_string() const;
     std::string                          numa_config_information_as_string() const;
     std::string                          thread_allocation_information_as_string() const;
+    // Wall time of the last setup of the threads and of the last clear of their histories
+    std::string thread_timing_information_as_string() const;
     std::string                          thread_binding_information_as_string() const;
 
    private:
+    // A single threaded search with its own table and histories, driven by one of the
+    // engine's threads. Slots share the options and the network with the engine, and are
+    // kept until the engine's threads change.
+    struct SearchSlot {
+        TranspositionTable                   tt;
+        std::map<NumaIndex, SharedHistories> sharedHists;
+        Search::SearchManager::UpdateContext updateContext;
+        ThreadPool                           threads;
+    };
+
+    // Readies one slot per thread of the engine but at most count, and returns how many.
+    // The caller sets the callbacks.
+    usize prepare_search_slots(usize count);
+
+    void                       init();
+    std::shared_ptr<LazyNumaReplicatedSystemWide<Eval::NNUE::Network>>
+    read_network(const Eval::NNUE::Network& current, const std::string& file) const;
+    std::optional<std::string> keep_host_option(const std::string& name);
+
     const std::string binaryDirectory;
 
-    NumaReplicationContext numaContext;
+    Engine* const                                                 host = nullptr;
+    std::unique_ptr<NumaReplicationContext>                       ownNumaContext;
+    std::unique_ptr<NumaReplicatedPublisher<Eval::NNUE::Network>> ownNetwork;
+    NumaReplicationContext&                                       numaContext;
 
     Position     pos;
     StateListPtr states;
 
-    OptionsMap                                        options;
-    ThreadPool                                        threads;
-    TranspositionTable                                tt;
-    LazyNumaReplicatedSystemWide<Eval::NNUE::Network> network;
+    // How pos was set up, the moves are those that were played successfully. The fen
+    // is empty when pos cannot be extended.
+    std::string              positionFen;
+    std::vector<std::string> positionMoves;
+    bool                     positionChess960 = false;
+
+    OptionsMap                                    options;
+    ThreadPool                                    threads;
+    TranspositionTable                            tt;
+    NumaReplicatedPublisher<Eval::NNUE::Network>& network;
 
+    std::thread                           networkLoader;
+    std::optional<std::string>            pendingEvalFile;
+    std::shared_ptr<const Book>           book;
     Search::SearchManager::UpdateContext  updateContext;
     std::function<void(std::string_view)> onVerifyNetwork;
     std::map<NumaIndex, SharedHistories>  sharedHists;
+
+    // Last, so that the slots are gone before the options and the network they use
+    std::vector<std::unique_ptr<SearchSlot>> searchSlots;
 };
 
 }  // namespace Stockfish
@@ -26,6 +26,7 @@
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include "nnue/network.h"
 #include "nnue/nnue_misc.h"
@@ -36,17 +37,11 @@
 
 namespace Stockfish {
 
-// Evaluate is the evaluator for the outer world. It returns a static evaluation
-// of the position from the point of view of the side to move.
-Value Eval::evaluate(const Eval::NNUE::Network&     network,
-                     const Position&                pos,
-                     Eval::NNUE::AccumulatorStack&  accumulators,
-                     Eval::NNUE::AccumulatorCaches& caches,
-                     int                            optimism) {
+namespace {
 
-    assert(!pos.checkers());
-
-    auto [psqt, positional] = network.evaluate(pos, accumulators, caches);
+// Blends the output of the network with optimism and damps it down with the material
+// and the halfmove clock.
+Value blend(const Position& pos, Value psqt, Value positional, int optimism) {
 
     Value nnue = psqt + positional;
 
@@ -67,6 +62,65 @@ Value Eval::evaluate(const Eval::NNUE::Network&     network,
     return v;
 }
 
+}  // namespace
+
+// Evaluate is the evaluator for the outer world. It returns a static evaluation
+// of the position from the point of view of the side to move.
+Value Eval::evaluate(const Eval::NNUE::Network&     network,
+                     const Position&                pos,
+                     Eval::NNUE::AccumulatorStack&  accumulators,
+                     Eval::NNUE::AccumulatorCaches& caches,
+                     Eval::NNUE::EvalCache&         evalCache,
+                     int                            optimism) {
+
+    assert(!pos.checkers());
+
+    Eval::NNUE::NetworkOutput output;
+    if (!evalCache.probe(pos.key(), output))
+    {
+        output = network.evaluate(pos, accumulators, caches);
+        evalCache.store(pos.key(), output);
+    }
+
+    auto [psqt, positional] = output;
+
+    return blend(pos, psqt, positional, optimism);
+}
+
+// Evaluates many independent positions at once, like evaluate() with no optimism.
+// Positions in check get VALUE_NONE.
+void Eval::evaluate_batch(const Eval::NNUE::Network&     network,
+                          const Position* const*         positions,
+                          usize                          count,
+                          Eval::NNUE::AccumulatorStack&  accumulators,
+                          Eval::NNUE::AccumulatorCaches& caches,
+                          Value*                         results) {
+
+    std::vector<const Position*>           quiet;
+    std::vector<usize>                     index;
+    std::vector<Eval::NNUE::NetworkOutput> outputs;
+
+    for (usize i = 0; i < count; ++i)
+    {
+        results[i] = VALUE_NONE;
+
+        if (!positions[i]->checkers())
+        {
+            quiet.push_back(positions[i]);
+            index.push_back(i);
+        }
+    }
+
+    outputs.resize(quiet.size());
+    network.evaluate_batch(quiet.data(), quiet.size(), accumulators, caches, outputs.data());
+
+    for (usize i = 0; i < quiet.size(); ++i)
+    {
+        auto [psqt, positional] = outputs[i];
+        results[index[i]]       = blend(*quiet[i], psqt, positional, 0);
+    }
+}
+
 // Like evaluate(), but instead of returning a value, it returns
 // a string (suitable for outputting to stdout) that contains the detailed
 // descriptions and values of each evaluation term. Useful for debugging.
@@ -91,7 +145,8 @@ std::string Eval::trace(Position& pos, const Eval::NNUE::Network& network) {
     v = pos.side_to_move() == WHITE ? v : -v;
     ss << "NNUE evaluation        " << 0.01 * UCIEngine::to_cp(v, pos) << " (white side)\n";
 
-    v = evaluate(network, pos, *accumulators, *caches, VALUE_ZERO);
+    Eval::NNUE::EvalCache noCache;
+    v = evaluate(network, pos, *accumulators, *caches, noCache, VALUE_ZERO);
     v = pos.side_to_move() == WHITE ? v : -v;
 
     ss << "Final evaluation      ";
@@ -39,6 +39,7 @@ namespace NNUE {
 class Network;
 struct AccumulatorCaches;
 class AccumulatorStack;
+class EvalCache;
 }
 
 std::string trace(Position& pos, const Eval::NNUE::Network& network);
@@ -47,7 +48,15 @@ Value evaluate(const NNUE::Network&           network,
                const Position&                pos,
                Eval::NNUE::AccumulatorStack&  accumulators,
                Eval::NNUE::AccumulatorCaches& caches,
+               Eval::NNUE::EvalCache&         evalCache,
                int                            optimism);
+
+void evaluate_batch(const NNUE::Network&           network,
+                    const Position* const*         positions,
+                    usize                          count,
+                    Eval::NNUE::AccumulatorStack&  accumulators,
+                    Eval::NNUE::AccumulatorCaches& caches,
+                    Value*                         results);
 }  // namespace Eval
 
 }  // namespace Stockfish
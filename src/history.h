@@ -199,12 +199,29 @@ using TTMoveHistory = StatsEntry<i16, 8192>;
 struct SharedHistories {
     SharedHistories(usize threadCount) :
         correctionHistory(threadCount),
-        pawnHistory(threadCount) {
+        pawnHistory(threadCount),
+        sharingThreads(threadCount) {
         assert((threadCount & (threadCount - 1)) == 0 && threadCount != 0);
         sizeMinus1         = correctionHistory.get_size() - 1;
         pawnHistSizeMinus1 = pawnHistory.get_size() - 1;
     }
 
+    // Reallocates the histories sized by the number of threads, which then have to be
+    // cleared. Returns false if the size does not change.
+    bool resize(usize threadCount) {
+        assert((threadCount & (threadCount - 1)) == 0 && threadCount != 0);
+
+        if (threadCount == sharingThreads)
+            return false;
+
+        correctionHistory  = UnifiedCorrectionHistory(threadCount);
+        pawnHistory        = PawnHistory(threadCount);
+        sharingThreads     = threadCount;
+        sizeMinus1         = correctionHistory.get_size() - 1;
+        pawnHistSizeMinus1 = pawnHistory.get_size() - 1;
+        return true;
+    }
+
     usize get_size() const { return sizeMinus1 + 1; }
 
     auto& pawn_entry(const Position& pos) {
@@ -243,7 +260,7 @@ struct SharedHistories {
 
 
    private:
-    usize sizeMinus1, pawnHistSizeMinus1;
+    usize sharingThreads, sizeMinus1, pawnHistSizeMinus1;
 };
 
 }  // namespace Stockfish
@@ -0,0 +1,271 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "libstockfish.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "attacks.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "misc.h"
+#include "position.h"
+#include "score.h"
+#include "search.h"
+#include "types.h"
+#include "uci.h"
+
+using namespace Stockfish;
+
+struct sf_engine {
+    explicit sf_engine(std::optional<std::string> path) :
+        engine(path) {
+
+        // The engine calls all of its listeners unconditionally
+        engine.set_on_update_no_moves([](const Engine::InfoShort&) {});
+        engine.set_on_update_full([](const Engine::InfoFull&) {});
+        engine.set_on_iter([](const Engine::InfoIter&) {});
+        engine.set_on_bestmove([](std::string_view, std::string_view) {});
+        engine.set_on_verify_network([this](std::string_view str) { lastError = str; });
+    }
+
+    Engine      engine;
+    std::string lastError;
+};
+
+namespace {
+
+// The PV is handed over without a copy, as an array of the raw move encoding
+static_assert(sizeof(Move) == sizeof(sf_move));
+
+void init_once() {
+    static std::once_flag flag;
+
+    std::call_once(flag, []() {
+        Bitboards::init();
+        Attacks::init();
+        Position::init();
+    });
+}
+
+sf_score to_sf_score(const Score& s) {
+    if (s.is<Score::Mate>())
+    {
+        const int plies = s.get<Score::Mate>().plies;
+        return {SF_SCORE_MATE, (plies > 0 ? plies + 1 : plies) / 2};
+    }
+
+    if (s.is<Score::Tablebase>())
+    {
+        const auto tb = s.get<Score::Tablebase>();
+        return {SF_SCORE_TB, tb.win ? tb.plies : -tb.plies};
+    }
+
+    return {SF_SCORE_CP, s.get<Score::InternalUnits>().value};
+}
+
+// Parses the 'w d l' string of the UCI output, which is only set with UCI_ShowWDL
+bool parse_wdl(std::string_view str, int wdl[3]) {
+    const char* p   = str.data();
+    const char* end = str.data() + str.size();
+
+    for (int i = 0; i < 3; ++i)
+    {
+        while (p < end && *p == ' ')
+            ++p;
+
+        auto [next, ec] = std::from_chars(p, end, wdl[i]);
+        if (ec != std::errc())
+            return false;
+
+        p = next;
+    }
+
+    return true;
+}
+
+// Copies a string_view to a null terminated buffer, moves have at most 5 characters
+template<usize N>
+const char* to_cstr(std::string_view str, char (&buf)[N]) {
+    const usize len = std::min(str.size(), N - 1);
+
+    std::memcpy(buf, str.data(), len);
+    buf[len] = '\0';
+
+    return buf;
+}
+
+}  // namespace
+
+extern "C" {
+
+sf_engine* sf_engine_new(const char* binaryPath) {
+    init_once();
+
+    return new sf_engine(binaryPath ? std::optional<std::string>(binaryPath) : std::nullopt);
+}
+
+void sf_engine_free(sf_engine* engine) { delete engine; }
+
+int sf_set_option(sf_engine* engine, const char* name, const char* value) {
+    auto& options = engine->engine.get_options();
+
+    if (!options.count(name))
+    {
+        engine->lastError = std::string("No such option: ") + name;
+        return -1;
+    }
+
+    std::istringstream is(std::string("name ") + name + " value " + (value ? value : ""));
+    options.setoption(is);
+
+    return 0;
+}
+
+int sf_set_position(sf_engine*         engine,
+                    const char*        fen,
+                    const char* const* moves,
+                    size_t             moveCount) {
+
+    const std::vector<std::string> moveList(moves, moves + moveCount);
+
+    if (auto err = engine->engine.set_position(fen, moveList))
+    {
+        engine->lastError = err->what();
+        return -1;
+    }
+
+    return 0;
+}
+
+const char* sf_last_error(const sf_engine* engine) { return engine->lastError.c_str(); }
+
+void sf_set_on_update_short(sf_engine* engine, sf_on_update_short f, void* user) {
+    engine->engine.set_on_update_no_moves([f, user](const Engine::InfoShort& info) {
+        if (!f)
+            return;
+
+        const sf_info_short out{info.depth, to_sf_score(info.score)};
+        f(&out, user);
+    });
+}
+
+void sf_set_on_update_full(sf_engine* engine, sf_on_update_full f, void* user) {
+    engine->engine.set_on_update_full([f, user](const Engine::InfoFull& info) {
+        if (!f)
+            return;
+
+        sf_info_full out{};
+
+        out.depth     = info.depth;
+        out.sel_depth = info.selDepth;
+        out.multipv   = info.multiPV;
+        out.score     = to_sf_score(info.score);
+        out.bound     = info.bound.empty()       ? SF_BOUND_EXACT
+                      : info.bound[0] == 'l' ? SF_BOUND_LOWER
+                                             : SF_BOUND_UPPER;
+        out.has_wdl   = !info.wdl.empty() && parse_wdl(info.wdl, out.wdl);
+        out.time_ms   = info.timeMs;
+        out.nodes     = info.nodes;
+        out.nps       = info.nps;
+        out.tb_hits   = info.tbHits;
+        out.hashfull  = info.hashfull;
+        out.chess960  = info.chess960;
+        out.pv        = reinterpret_cast<const sf_move*>(info.pv->begin());
+        out.pv_length = info.pv->size();
+
+        f(&out, user);
+    });
+}
+
+void sf_set_on_iter(sf_engine* engine, sf_on_iter f, void* user) {
+    engine->engine.set_on_iter([f, user](const Engine::InfoIter& info) {
+        if (!f)
+            return;
+
+        char                    currmove[8];
+        const sf_info_iteration out{info.depth, to_cstr(info.currmove, currmove),
+                                    info.currmovenumber};
+        f(&out, user);
+    });
+}
+
+void sf_set_on_bestmove(sf_engine* engine, sf_on_bestmove f, void* user) {
+    engine->engine.set_on_bestmove([f, user](std::string_view bestmove, std::string_view ponder) {
+        if (!f)
+            return;
+
+        char bm[8], pm[8];
+        f(to_cstr(bestmove, bm), to_cstr(ponder, pm), user);
+    });
+}
+
+int sf_go(sf_engine* engine, const sf_limits* in) {
+    // The engine would terminate the process, which a library must not do
+    if (!engine->engine.network_loaded())
+    {
+        engine->lastError = "The network file "
+                          + std::string(engine->engine.get_options()["EvalFile"])
+                          + " was not loaded successfully";
+        return -1;
+    }
+
+    Search::LimitsType limits;
+
+    limits.startTime = now();  // The search starts as early as possible
+
+    if (in)
+    {
+        limits.time[WHITE] = in->time[WHITE];
+        limits.time[BLACK] = in->time[BLACK];
+        limits.inc[WHITE]  = in->inc[WHITE];
+        limits.inc[BLACK]  = in->inc[BLACK];
+        limits.movestogo   = in->movestogo;
+        limits.depth       = in->depth;
+        limits.mate        = in->mate;
+        limits.movetime    = in->movetime;
+        limits.nodes       = in->nodes;
+        limits.infinite    = in->infinite;
+        limits.ponderMode  = in->ponder;
+    }
+
+    engine->engine.go(limits);
+    return 0;
+}
+
+void sf_stop(sf_engine* engine) { engine->engine.stop(); }
+
+void sf_ponderhit(sf_engine* engine) { engine->engine.set_ponderhit(false); }
+
+void sf_wait(sf_engine* engine) { engine->engine.wait_for_search_finished(); }
+
+void sf_move_to_uci(sf_move move, int chess960, char* buf) {
+    const std::string str = UCIEngine::move(Move(move), chess960);
+
+    std::memcpy(buf, str.c_str(), str.size() + 1);
+}
+
+}  // extern "C"
@@ -0,0 +1,148 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// C interface to the engine, built as libstockfish.a and libstockfish.so with
+// 'make library'. It drives the same Engine object as the UCI front end, but search
+// updates are delivered as structs instead of formatted info lines.
+//
+// Callbacks are called from the search thread. Pointers they receive, including the
+// PV moves, are only valid for the duration of the call.
+
+#ifndef LIBSTOCKFISH_H_INCLUDED
+#define LIBSTOCKFISH_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SF_API_VERSION 1
+
+typedef struct sf_engine sf_engine;
+
+// A move in the internal 16 bit encoding: bits 0-5 are the destination square,
+// bits 6-11 the origin square (a1 = 0, b1 = 1, ..., h8 = 63), bits 12-13 the promotion
+// piece type minus knight, and bits 14-15 the move type (0 normal, 1 promotion,
+// 2 en passant, 3 castling). Castling is encoded as the king capturing its own rook.
+typedef uint16_t sf_move;
+
+enum sf_score_type {
+    SF_SCORE_CP,    // value is in centipawns
+    SF_SCORE_MATE,  // value is the number of moves to mate, negative if mated
+    SF_SCORE_TB     // value is the number of plies to a tablebase win, negative for a loss
+};
+
+enum sf_bound {
+    SF_BOUND_EXACT,
+    SF_BOUND_LOWER,
+    SF_BOUND_UPPER
+};
+
+typedef struct {
+    int type;  // One of sf_score_type
+    int value;
+} sf_score;
+
+typedef struct {
+    int      depth;
+    sf_score score;
+} sf_info_short;
+
+typedef struct {
+    int            depth;
+    int            sel_depth;
+    size_t         multipv;
+    sf_score       score;
+    int            bound;    // One of sf_bound
+    int            has_wdl;  // wdl is only set when the UCI_ShowWDL option is on
+    int            wdl[3];   // Win, draw and loss expectation in per mille
+    uint64_t       time_ms;
+    uint64_t       nodes;
+    uint64_t       nps;
+    uint64_t       tb_hits;
+    int            hashfull;
+    int            chess960;
+    const sf_move* pv;
+    size_t         pv_length;
+} sf_info_full;
+
+typedef struct {
+    int         depth;
+    const char* currmove;
+    size_t      currmovenumber;
+} sf_info_iteration;
+
+// Search limits, fields left at zero are unused. Times are in milliseconds.
+typedef struct {
+    int64_t time[2];  // Remaining time of white and black
+    int64_t inc[2];
+    int     movestogo;
+    int     depth;
+    int     mate;
+    int64_t movetime;
+    int64_t nodes;
+    int     infinite;
+    int     ponder;
+} sf_limits;
+
+typedef void (*sf_on_update_short)(const sf_info_short* info, void* user);
+typedef void (*sf_on_update_full)(const sf_info_full* info, void* user);
+typedef void (*sf_on_iter)(const sf_info_iteration* info, void* user);
+typedef void (*sf_on_bestmove)(const char* bestmove, const char* ponder, void* user);
+
+// Global initialization is done on the first call. binaryPath is used like argv[0] of the
+// executable to locate network files and may be NULL.
+sf_engine* sf_engine_new(const char* binaryPath);
+void       sf_engine_free(sf_engine* engine);
+
+// Sets a UCI option, returns 0 on success and -1 if there is no such option.
+int sf_set_option(sf_engine* engine, const char* name, const char* value);
+
+// Sets the position from a FEN and a list of moves in UCI notation. Returns 0 on
+// success, -1 otherwise, and the reason is then available from sf_last_error().
+int sf_set_position(sf_engine*         engine,
+                    const char*        fen,
+                    const char* const* moves,
+                    size_t             moveCount);
+
+const char* sf_last_error(const sf_engine* engine);
+
+// Callbacks can be changed only while no search is running. NULL disables them.
+void sf_set_on_update_short(sf_engine* engine, sf_on_update_short f, void* user);
+void sf_set_on_update_full(sf_engine* engine, sf_on_update_full f, void* user);
+void sf_set_on_iter(sf_engine* engine, sf_on_iter f, void* user);
+void sf_set_on_bestmove(sf_engine* engine, sf_on_bestmove f, void* user);
+
+// Starts searching and returns 0 immediately, the end of the search is signalled by
+// the bestmove callback. Returns -1 without searching if no network is loaded, and the
+// reason is then available from sf_last_error().
+int  sf_go(sf_engine* engine, const sf_limits* limits);
+void sf_stop(sf_engine* engine);
+void sf_ponderhit(sf_engine* engine);
+void sf_wait(sf_engine* engine);
+
+// Writes the UCI notation of a move to buf, which must hold at least 8 characters
+void sf_move_to_uci(sf_move move, int chess960, char* buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // #ifndef LIBSTOCKFISH_H_INCLUDED
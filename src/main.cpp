@@ -16,8 +16,10 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <string>
 
 #include "attacks.h"
 #include "bitboard.h"
@@ -39,13 +41,35 @@ __attribute__((used)) // keep main alive
 int main(int argc, char* argv[]) {
     std::cout << engine_info() << std::endl;
 
+    // --startup-profile reports the time of the steps of the startup to stderr, the
+    // other arguments are passed on
+    const bool profileStartup = std::find(argv + 1, argv + argc, std::string("--startup-profile"))
+                             != argv + argc;
+
+    if (profileStartup)
+    {
+        argc = int(std::remove(argv + 1, argv + argc, std::string("--startup-profile")) - argv);
+        start_startup_profile();
+    }
+
+    startup_step("Process start to main");
+
     Bitboards::init();
+    startup_step("Bitboards::init");
+
     Attacks::init();
+    startup_step("Attacks::init");
+
     Position::init();
+    startup_step("Position::init");
 
     auto uci = std::make_unique<UCIEngine>(argc, argv);
 
     Tune::init(uci->engine_options());
+    startup_step("Tune::init");
+
+    if (profileStartup)
+        std::cerr << startup_profile() << std::endl;
 
     uci->loop();
 
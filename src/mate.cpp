@@ -0,0 +1,332 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mate.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+#include "memory.h"
+#include "movegen.h"
+#include "position.h"
+
+namespace Stockfish::Mate {
+
+namespace {
+
+// Proof and disproof numbers of solved nodes. A proven node has pn 0 and dn Infinite,
+// a disproven one pn Infinite and dn 0.
+constexpr u32 Infinite = std::numeric_limits<u32>::max();
+
+// Sums that are not infinite saturate just below, as they do not solve the node
+u32 add(u32 a, u32 b) {
+    if (a == Infinite || b == Infinite)
+        return Infinite;
+
+    return u32(std::min(u64(a) + b, u64(Infinite - 1)));
+}
+
+Key mix(Key key, int depth) { return key ^ (u64(depth) * 0x9E3779B97F4A7C15ULL); }
+
+// A child with the proof and disproof numbers it has as long as it is not in the table
+struct Child {
+    Move move;
+    Key  key;
+    u32  pn, dn;
+};
+
+}  // namespace
+
+Solver::~Solver() { aligned_large_pages_free(table); }
+
+void Solver::resize(usize size) {
+    if (size == mbSize && table)
+        return;
+
+    aligned_large_pages_free(table);
+
+    mbSize     = size;
+    entryCount = mbSize * 1024 * 1024 / sizeof(Entry);
+    table      = static_cast<Entry*>(aligned_large_pages_alloc(entryCount * sizeof(Entry)));
+
+    if (!table)
+    {
+        std::cerr << "Failed to allocate " << mbSize << "MB for the mate solver." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+Solver::Entry* Solver::probe(Key key, int depth) const {
+    Entry& e = table[mul_hi64(mix(key, depth), entryCount)];
+    return e.key == key && e.depth == depth ? &e : nullptr;
+}
+
+// A single entry per slot, always replaced. If the proof of a node is lost this way,
+// it is searched again when the PV is extracted.
+void Solver::store(Key key, int depth, u32 pn, u32 dn, int plies) {
+    Entry& e = table[mul_hi64(mix(key, depth), entryCount)];
+    e        = {key, pn, dn, u16(depth), u16(plies)};
+}
+
+// The root moves can be restricted with 'searchmoves'. The root is the only attacker
+// node with rootDepth moves left.
+bool Solver::excluded(Move m, int depth, bool attacker) const {
+    return attacker && depth == rootDepth
+        && std::find(rootMoves->begin(), rootMoves->end(), m) == rootMoves->end();
+}
+
+Solver::Result Solver::solve(Position&                pos,
+                             const std::vector<Move>& moves,
+                             int                      mateMoves,
+                             RelaxedAtomic<u64>&      nodeCount,
+                             const StopCondition&     stopCondition,
+                             std::vector<Move>&       pv) {
+
+    assert(table);
+
+    std::memset(static_cast<void*>(table), 0, entryCount * sizeof(Entry));
+
+    rootMoves = &moves;
+    nodes     = &nodeCount;
+    stop      = &stopCondition;
+    stopped   = false;
+
+    pv.clear();
+
+    for (rootDepth = 1; rootDepth <= mateMoves; ++rootDepth)
+    {
+        mid(pos, rootDepth, true, Infinite, Infinite);
+
+        if (stopped)
+            return STOPPED;
+
+        const Entry* e = probe(pos.key(), rootDepth);
+
+        if (e && e->pn == 0)
+            break;
+    }
+
+    if (rootDepth > mateMoves)
+        return NO_MATE;
+
+    // Follow the shortest mate against the longest defence
+    StateInfo states[MAX_PLY];
+    int       depth    = rootDepth;
+    bool      attacker = true;
+
+    while (pv.size() < MAX_PLY && MoveList<LEGAL>(pos).size())
+    {
+        Move m = proven_move(pos, depth, attacker);
+
+        if (m == Move::none())
+        {
+            mid(pos, depth, attacker, Infinite, Infinite);
+
+            if (stopped || (m = proven_move(pos, depth, attacker)) == Move::none())
+                break;
+        }
+
+        pos.do_move(m, states[pv.size()]);
+        pv.push_back(m);
+
+        depth -= attacker;
+        attacker = !attacker;
+    }
+
+    for (auto it = pv.rbegin(); it != pv.rend(); ++it)
+        pos.undo_move(*it);
+
+    // The first move is proven even if the line is incomplete
+    return pv.empty() ? STOPPED : MATE;
+}
+
+// The df-pn search of a node with the thresholds given by its parent, in terms of
+// phi and delta, which are the proof and disproof numbers of attacker nodes, and the
+// reverse for defender nodes. Attacker nodes are OR nodes and defender nodes AND nodes,
+// so phi is the minimum delta of the children and delta the sum of their phi. Defender
+// nodes keep the number of attacker moves left of their parent.
+void Solver::mid(Position& pos, int depth, bool attacker, u32 thPhi, u32 thDelta) {
+
+    ++*nodes;
+
+    if ((*stop)())
+    {
+        stopped = true;
+        return;
+    }
+
+    const Key       key = pos.key();
+    MoveList<LEGAL> legal(pos);
+
+    if (!legal.size())
+    {
+        if (!attacker && pos.checkers())
+            store(key, depth, 0, Infinite, 0);
+        else
+            store(key, depth, Infinite, 0, 0);
+        return;
+    }
+
+    if ((!attacker && depth == 0) || pos.rule50_count() >= 100)
+    {
+        store(key, depth, Infinite, 0, 0);
+        return;
+    }
+
+    const int childDepth = attacker ? depth - 1 : depth;
+
+    // With one move left only checks can mate, and checks are tried first anyway.
+    // The number of replies is a cheap estimate of how hard a child is to prove
+    // for a defender, or to disprove for an attacker. Children that are mate or
+    // stalemate, or cannot be mate anymore, are solved right away.
+    Child     children[MAX_MOVES];
+    usize     count = 0, checks = 0;
+    StateInfo st;
+
+    for (const auto& m : legal)
+    {
+        const bool givesCheck = pos.gives_check(m);
+
+        if (excluded(m, depth, attacker) || (attacker && depth == 1 && !givesCheck))
+            continue;
+
+        pos.do_move(m, st);
+
+        const Key childKey = pos.key();
+        const u32 replies  = u32(MoveList<LEGAL>(pos).size());
+        const u32 mated    = attacker && pos.checkers();
+
+        pos.undo_move(m);
+
+        Child& c = children[count++];
+        c        = {m, childKey, attacker ? replies : 1, attacker ? 1 : replies};
+
+        if (!replies || (attacker && childDepth == 0))
+        {
+            c.pn = !replies && mated ? 0 : Infinite;
+            c.dn = !replies && mated ? Infinite : 0;
+            store(childKey, childDepth, c.pn, c.dn, 0);
+        }
+
+        if (givesCheck)
+            std::swap(children[checks++], children[count - 1]);
+    }
+
+    if (!count)
+    {
+        store(key, depth, Infinite, 0, 0);
+        return;
+    }
+
+    while (true)
+    {
+        u32   phi = Infinite, delta = 0, delta2 = Infinite, bestPhi = 0;
+        usize best  = 0;
+        int   plies = attacker ? MAX_PLY : 0;
+
+        for (usize i = 0; i < count; ++i)
+        {
+            const Entry* e  = probe(children[i].key, childDepth);
+            const u32    pn = e ? e->pn : children[i].pn;
+            const u32    dn = e ? e->dn : children[i].dn;
+
+            const u32 childPhi   = attacker ? dn : pn;
+            const u32 childDelta = attacker ? pn : dn;
+
+            delta = add(delta, childPhi);
+
+            if (childDelta < phi)
+            {
+                delta2  = phi;
+                phi     = childDelta;
+                bestPhi = childPhi;
+                best    = i;
+            }
+            else if (childDelta < delta2)
+                delta2 = childDelta;
+
+            if (pn == 0)
+            {
+                const int childPlies = (e ? e->plies : 0) + 1;
+                plies = attacker ? std::min(plies, childPlies) : std::max(plies, childPlies);
+            }
+        }
+
+        if (phi >= thPhi || delta >= thDelta)
+        {
+            store(key, depth, attacker ? phi : delta, attacker ? delta : phi, plies);
+            return;
+        }
+
+        // The child is searched until it is no longer the best one or would exceed the
+        // thresholds of this node. It may go a bit beyond the second best one (the 1 + e
+        // trick), which saves many switches between siblings that are about as good.
+        const u32 childThPhi   = thDelta == Infinite ? Infinite : thDelta - delta + bestPhi;
+        const u32 childThDelta = std::min(thPhi, add(delta2, delta2 / 4 + 1));
+
+        pos.do_move(children[best].move, st);
+        mid(pos, childDepth, !attacker, childThPhi, childThDelta);
+        pos.undo_move(children[best].move);
+
+        if (stopped)
+            return;
+    }
+}
+
+// The move of a proven node on the mating line: the fastest mate for the attacker
+// and the slowest one for the defender. None if a child is not known to be proven.
+Move Solver::proven_move(Position& pos, int depth, bool attacker) {
+
+    const int childDepth = attacker ? depth - 1 : depth;
+    Move      best       = Move::none();
+    int       bestPlies  = attacker ? MAX_PLY + 1 : -1;
+    StateInfo st;
+
+    for (const auto& m : MoveList<LEGAL>(pos))
+    {
+        if (excluded(m, depth, attacker))
+            continue;
+
+        pos.do_move(m, st);
+        const Entry* e = probe(pos.key(), childDepth);
+        pos.undo_move(m);
+
+        if (!e || e->pn != 0)
+        {
+            if (!attacker)
+                return Move::none();
+
+            continue;
+        }
+
+        if (attacker ? e->plies < bestPlies : e->plies > bestPlies)
+        {
+            best      = m;
+            bestPlies = e->plies;
+        }
+    }
+
+    return best;
+}
+
+}  // namespace Stockfish::Mate
@@ -0,0 +1,101 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MATE_H_INCLUDED
+#define MATE_H_INCLUDED
+
+#include <functional>
+#include <vector>
+
+#include "misc.h"
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+
+namespace Mate {
+
+// Solves 'go mate' with a depth-first proof-number search (df-pn) instead of
+// alpha-beta. The side to move at the root is the attacker, which must mate within
+// the given number of moves, and every defence has to be refuted. Proof and disproof
+// numbers are kept in a table of their own, keyed by the position and the number of
+// attacker moves left, so that the bounded search never has to deal with cycles.
+class Solver {
+   public:
+    enum Result {
+        MATE,     // pv is a shortest mating line
+        NO_MATE,  // there is no mate within the given number of moves
+        STOPPED
+    };
+
+    using StopCondition = std::function<bool()>;
+
+    Solver() = default;
+    ~Solver();
+
+    Solver(const Solver&)            = delete;
+    Solver& operator=(const Solver&) = delete;
+
+    // Reallocates the table if its size changed
+    void resize(usize mbSize);
+
+    // Deepens the search one attacker move at a time up to 'moves', so that the first
+    // mate found is a shortest one. Only the given root moves are tried. The stop
+    // condition is checked at every node, which are also added to 'nodes'.
+    Result solve(Position&                pos,
+                 const std::vector<Move>& rootMoves,
+                 int                      moves,
+                 RelaxedAtomic<u64>&      nodes,
+                 const StopCondition&     stop,
+                 std::vector<Move>&       pv);
+
+    // Length in plies of the mate found by the last solve()
+    int mate_plies() const { return 2 * rootDepth - 1; }
+
+   private:
+    struct Entry {
+        Key key;
+        u32 pn, dn;
+        u16 depth;
+        u16 plies;  // Length of the mating line once proven
+    };
+
+    Entry* probe(Key key, int depth) const;
+    void   store(Key key, int depth, u32 pn, u32 dn, int plies);
+
+    bool excluded(Move m, int depth, bool attacker) const;
+    void mid(Position& pos, int depth, bool attacker, u32 thPhi, u32 thDelta);
+    Move proven_move(Position& pos, int depth, bool attacker);
+
+    Entry* table      = nullptr;
+    usize  entryCount = 0;
+    usize  mbSize     = 0;
+
+    const std::vector<Move>* rootMoves = nullptr;
+    int                      rootDepth = 0;
+    RelaxedAtomic<u64>*      nodes     = nullptr;
+    const StopCondition*     stop      = nullptr;
+    bool                     stopped   = false;
+};
+
+}  // namespace Mate
+
+}  // namespace Stockfish
+
+#endif  // #ifndef MATE_H_INCLUDED
@@ -18,6 +18,7 @@
 
 #include "memory.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>  // std::cerr
 
@@ -32,6 +33,15 @@
     #include <cstring>
     #include <mutex>
     #include <map>
+    #include <sys/syscall.h>
+#endif
+
+#if !defined(_WIN32)
+    #include <cerrno>
+    #include <cstring>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
 #endif
 
 #if defined(__APPLE__) || defined(__ANDROID__) || defined(__OpenBSD__) \
@@ -251,4 +261,123 @@ void aligned_large_pages_free(void* mem) {
 }
 
 #endif
+
+
+// map_file() maps `size` bytes of the file at `path`, starting at `offset`, into
+// memory. The offset must be a multiple of the system page size. With copyOnWrite
+// modifications stay private to the process, otherwise they are written back to the
+// file. Returns nullptr on failure or on platforms where mapping is not supported,
+// in which case the caller is expected to fall back to reading the file.
+
+#if defined(_WIN32)
+
+void* map_file(const std::string&, usize, usize, bool) { return nullptr; }
+
+void unmap_file(void*, usize) {}
+
+#else
+
+void* map_file(const std::string& path, usize offset, usize size, bool copyOnWrite) {
+    int fd = open(path.c_str(), copyOnWrite ? O_RDONLY : O_RDWR);
+    if (fd == -1)
+        return nullptr;
+
+    // With MAP_PRIVATE a read-only descriptor still allows writable private pages
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, copyOnWrite ? MAP_PRIVATE : MAP_SHARED,
+                     fd, off_t(offset));
+    close(fd);  // The mapping keeps its own reference to the file
+
+    if (mem == MAP_FAILED)
+        return nullptr;
+
+    #if defined(MADV_WILLNEED)
+    // Accesses are random, so start reading the whole file in the background
+    madvise(mem, size, MADV_WILLNEED);
+    #endif
+
+    return mem;
+}
+
+void unmap_file(void* mem, usize size) {
+    if (mem && munmap(mem, size) != 0)
+    {
+        std::cerr << "munmap failed: " << strerror(errno) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+#endif
+
+
+// NUMA placement of memory, using the system calls directly, so that no libnuma is needed.
+// bind_to_numa_node() sets a preferred node for all pages overlapping `size` bytes at `mem`,
+// moving the pages already present, and numa_nodes_of() queries the node of every
+// `stride`-th byte of a range, which is -1 where unknown.
+
+#if defined(__linux__) && !defined(__ANDROID__) && defined(SYS_mbind) && defined(SYS_move_pages)
+
+static constexpr int MpolPreferred = 1;       // MPOL_PREFERRED
+static constexpr int MpolMfMove    = 1 << 1;  // MPOL_MF_MOVE
+
+int current_numa_node() {
+    unsigned cpu, node;
+    return syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? int(node) : -1;
+}
+
+bool bind_to_numa_node(void* mem, usize size, int node) {
+    const usize pageSize = usize(sysconf(_SC_PAGESIZE));
+    const usize start    = usize(mem) & ~(pageSize - 1);
+    const usize end      = (usize(mem) + size + pageSize - 1) & ~(pageSize - 1);
+
+    if (node < 0 || node >= 1024 || end <= start)
+        return false;
+
+    unsigned long nodeMask[1024 / (8 * sizeof(unsigned long))] = {};
+    nodeMask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+
+    return syscall(SYS_mbind, start, end - start, MpolPreferred, nodeMask, 1024 + 1, MpolMfMove)
+        == 0;
+}
+
+std::vector<int> numa_nodes_of(const void* mem, usize size, usize stride) {
+    const usize pageSize = usize(sysconf(_SC_PAGESIZE));
+    const usize count    = (size + stride - 1) / stride;
+
+    std::vector<int>   nodes(count, -1);
+    std::vector<void*> pages;
+
+    // Query in batches to bound the temporary memory
+    for (usize first = 0; first < count; first += 4096)
+    {
+        const usize batch = std::min(count - first, usize(4096));
+
+        pages.resize(batch);
+        for (usize i = 0; i < batch; ++i)
+            pages[i] = reinterpret_cast<void*>((usize(mem) + (first + i) * stride)
+                                               & ~(pageSize - 1));
+
+        // Without target nodes, move_pages() only reports where the pages are
+        if (syscall(SYS_move_pages, 0, batch, pages.data(), nullptr, &nodes[first], 0) != 0)
+            std::fill_n(&nodes[first], batch, -1);
+    }
+
+    // Errors such as pages not yet present are reported as negative values
+    for (int& n : nodes)
+        n = std::max(n, -1);
+
+    return nodes;
+}
+
+#else
+
+int current_numa_node() { return -1; }
+
+bool bind_to_numa_node(void*, usize, int) { return false; }
+
+std::vector<int> numa_nodes_of(const void*, usize size, usize stride) {
+    return std::vector<int>((size + stride - 1) / stride, -1);
+}
+
+#endif
+
 }  // namespace Stockfish
@@ -23,8 +23,10 @@
 #include <cstdint>
 #include <memory>
 #include <new>
+#include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 #include <cstring>
 
 #include "types.h"
@@ -74,6 +76,16 @@ void  aligned_large_pages_free(void* mem);
 
 bool has_large_pages();
 
+// Memory backed by a file, see map_file() for the constraints on `offset`
+void* map_file(const std::string& path, usize offset, usize size, bool copyOnWrite);
+void  unmap_file(void* mem, usize size);
+
+// NUMA placement of memory, Linux only. Nodes are numbered as by the system, not as in
+// NumaConfig. See memory.cpp.
+int              current_numa_node();
+bool             bind_to_numa_node(void* mem, usize size, int node);
+std::vector<int> numa_nodes_of(const void* mem, usize size, usize stride);
+
 // Frees memory which was placed there with placement new.
 // Works for both single objects and arrays of unknown bound.
 template<typename T, typename FREE_FUNC>
@@ -22,6 +22,7 @@
 #include <atomic>
 #include <cassert>
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <fstream>
@@ -32,6 +33,8 @@
 #include <mutex>
 #include <sstream>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "types.h"
 
@@ -416,6 +419,49 @@ void dbg_clear() {
     extremes.fill({});
 }
 
+namespace {
+
+// Initialized before main(), so that the profile includes the loading of the binary
+const auto ProcessStart = std::chrono::steady_clock::now();
+
+bool                                        profilingStartup = false;
+std::vector<std::pair<std::string, double>> startupSteps;  // Name and end in ms
+
+}  // namespace
+
+void start_startup_profile() { profilingStartup = true; }
+
+void startup_step(const std::string& name) {
+    if (!profilingStartup)
+        return;
+
+    const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - ProcessStart;
+
+    startupSteps.emplace_back(name, elapsed.count());
+}
+
+std::string startup_profile() {
+    std::ostringstream ss;
+    double             last = 0;
+
+    ss << std::fixed << std::setprecision(2) << "\n===========================";
+
+    for (const auto& [name, end] : startupSteps)
+    {
+        ss << '\n' << std::left << std::setw(27) << name << ": " << std::right << std::setw(8)
+           << end - last << " ms";
+        last = end;
+    }
+
+    ss << '\n' << std::left << std::setw(27) << "Total" << ": " << std::right << std::setw(8)
+       << last << " ms";
+
+    profilingStartup = false;
+    startupSteps.clear();
+    return ss.str();
+}
+
 // Used to serialize access to std::cout
 // to avoid multiple threads writing at the same time.
 std::ostream& operator<<(std::ostream& os, SyncCout sc) {
@@ -161,6 +161,14 @@ void dbg_correl_of(i64 value1, i64 value2, int slot = 0);
 void dbg_print();
 void dbg_clear();
 
+// The startup profile, reported with --startup-profile, times the steps of the startup
+// from the start of the process. A step lasts from the previous one until
+// startup_step() is called with its name, and steps are only recorded between
+// start_startup_profile() and startup_profile(), which returns the report.
+void        start_startup_profile();
+void        startup_step(const std::string& name);
+std::string startup_profile();
+
 using TimePoint = std::chrono::milliseconds::rep;  // A value in milliseconds
 static_assert(sizeof(TimePoint) == sizeof(i64), "TimePoint should be 64 bits");
 inline TimePoint now() {
@@ -21,6 +21,7 @@
 #ifndef NNUE_LAYERS_AFFINE_TRANSFORM_H_INCLUDED
 #define NNUE_LAYERS_AFFINE_TRANSFORM_H_INCLUDED
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 
@@ -347,6 +348,155 @@ class AffineTransform {
 #endif
     }
 
+    // Forward propagation of count inputs, e.g. of a batch of positions. The inputs are
+    // taken in tiles, and each vector of weights is loaded once per tile and used for all
+    // its inputs, so that the weights are streamed once per tile instead of per input.
+    // A tile has as many inputs as leave registers for all their accumulators, inputs
+    // which do not fill a tile are propagated one by one.
+    void propagate_batch(const InputType* const* inputs,
+                         OutputType* const*      outputs,
+                         IndexType               count) const {
+        IndexType b = 0;
+
+#ifdef ENABLE_SEQ_OPT
+
+        if constexpr (OutputDimensions > 1)
+        {
+    #if defined(USE_AVX512)
+            using vec_t = __m512i;
+        #define vec_set_32 _mm512_set1_epi32
+        #define vec_add_dpbusd_32 SIMD::m512_add_dpbusd_epi32
+    #elif defined(USE_AVX2)
+            using vec_t = __m256i;
+        #define vec_set_32 _mm256_set1_epi32
+        #define vec_add_dpbusd_32 SIMD::m256_add_dpbusd_epi32
+    #elif defined(USE_SSSE3)
+            using vec_t = __m128i;
+        #define vec_set_32 _mm_set1_epi32
+        #define vec_add_dpbusd_32 SIMD::m128_add_dpbusd_epi32
+    #elif defined(USE_NEON_DOTPROD)
+            using vec_t = int32x4_t;
+        #define vec_set_32 vdupq_n_s32
+        #define vec_add_dpbusd_32(acc, a, b) \
+            SIMD::dotprod_m128_add_dpbusd_epi32(acc, vreinterpretq_s8_s32(a), \
+                                                vreinterpretq_s8_s32(b))
+    #elif defined(USE_LASX)
+            using vec_t = __m256i;
+        #define vec_set_32 __lasx_xvreplgr2vr_w
+        #define vec_add_dpbusd_32 SIMD::lasx_m256_add_dpbusd_epi32
+    #elif defined(USE_LSX)
+            using vec_t = __m128i;
+        #define vec_set_32 __lsx_vreplgr2vr_w
+        #define vec_add_dpbusd_32 SIMD::lsx_m128_add_dpbusd_epi32
+    #endif
+
+            static constexpr IndexType OutputSimdWidth = sizeof(vec_t) / sizeof(OutputType);
+
+            constexpr IndexType NumChunks = ceil_to_multiple<IndexType>(InputDimensions, 8) / 4;
+            constexpr IndexType NumAccums = OutputDimensions / OutputSimdWidth;
+            constexpr IndexType Tile      = std::max<IndexType>(1, 8 / NumAccums);
+
+            const vec_t* biasvec = reinterpret_cast<const vec_t*>(biases);
+
+            for (; Tile > 1 && b + Tile <= count; b += Tile)
+            {
+                vec_t acc[Tile][NumAccums];
+                for (IndexType t = 0; t < Tile; ++t)
+                    for (IndexType k = 0; k < NumAccums; ++k)
+                        acc[t][k] = biasvec[k];
+
+                for (IndexType i = 0; i < NumChunks; ++i)
+                {
+                    const auto col =
+                      reinterpret_cast<const vec_t*>(&weights[i * OutputDimensions * 4]);
+
+                    vec_t in[Tile];
+                    for (IndexType t = 0; t < Tile; ++t)
+                        in[t] = vec_set_32(load_as<i32>(inputs[b + t] + i * sizeof(i32)));
+
+                    for (IndexType k = 0; k < NumAccums; ++k)
+                    {
+                        const vec_t w = col[k];
+                        for (IndexType t = 0; t < Tile; ++t)
+                            vec_add_dpbusd_32(acc[t][k], in[t], w);
+                    }
+                }
+
+                for (IndexType t = 0; t < Tile; ++t)
+                    for (IndexType k = 0; k < NumAccums; ++k)
+                        reinterpret_cast<vec_t*>(outputs[b + t])[k] = acc[t][k];
+            }
+
+    #undef vec_set_32
+    #undef vec_add_dpbusd_32
+        }
+        else if constexpr (OutputDimensions == 1)
+        {
+    #if defined(USE_AVX2)
+            using vec_t = __m256i;
+        #define vec_setzero() _mm256_setzero_si256()
+        #define vec_add_dpbusd_32 SIMD::m256_add_dpbusd_epi32
+        #define vec_hadd SIMD::m256_hadd
+    #elif defined(USE_SSSE3)
+            using vec_t = __m128i;
+        #define vec_setzero() _mm_setzero_si128()
+        #define vec_add_dpbusd_32 SIMD::m128_add_dpbusd_epi32
+        #define vec_hadd SIMD::m128_hadd
+    #elif defined(USE_NEON_DOTPROD)
+            using vec_t = int32x4_t;
+        #define vec_setzero() vdupq_n_s32(0)
+        #define vec_add_dpbusd_32(acc, a, b) \
+            SIMD::dotprod_m128_add_dpbusd_epi32(acc, vreinterpretq_s8_s32(a), \
+                                                vreinterpretq_s8_s32(b))
+        #define vec_hadd SIMD::neon_m128_hadd
+    #elif defined(USE_LASX)
+            using vec_t = __m256i;
+        #define vec_setzero() __lasx_xvldi(0)
+        #define vec_add_dpbusd_32 SIMD::lasx_m256_add_dpbusd_epi32
+        #define vec_hadd SIMD::lasx_m256_hadd
+    #elif defined(USE_LSX)
+            using vec_t = __m128i;
+        #define vec_setzero() __lsx_vldi(0)
+        #define vec_add_dpbusd_32 SIMD::lsx_m128_add_dpbusd_epi32
+        #define vec_hadd SIMD::lsx_m128_hadd
+    #endif
+
+            static constexpr IndexType InputSimdWidth = sizeof(vec_t) / sizeof(InputType);
+
+            constexpr IndexType NumChunks = PaddedInputDimensions / InputSimdWidth;
+            constexpr IndexType Tile      = 8;
+
+            const auto row = reinterpret_cast<const vec_t*>(&weights[0]);
+
+            for (; b + Tile <= count; b += Tile)
+            {
+                vec_t sum[Tile];
+                for (IndexType t = 0; t < Tile; ++t)
+                    sum[t] = vec_setzero();
+
+                for (IndexType j = 0; j < NumChunks; ++j)
+                {
+                    const vec_t w = row[j];
+                    for (IndexType t = 0; t < Tile; ++t)
+                        vec_add_dpbusd_32(sum[t], reinterpret_cast<const vec_t*>(inputs[b + t])[j],
+                                          w);
+                }
+
+                for (IndexType t = 0; t < Tile; ++t)
+                    outputs[b + t][0] = vec_hadd(sum[t], biases[0]);
+            }
+
+    #undef vec_setzero
+    #undef vec_add_dpbusd_32
+    #undef vec_hadd
+        }
+
+#endif
+
+        for (; b < count; ++b)
+            propagate(inputs[b], outputs[b]);
+    }
+
    private:
     using BiasType   = OutputType;
     using WeightType = i8;
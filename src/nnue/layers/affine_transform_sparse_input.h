@@ -282,6 +282,112 @@ class AffineTransformSparseInput {
 #endif
     }
 
+    // Forward propagation of count inputs, e.g. of a batch of positions. As in
+    // AffineTransform::propagate_batch(), each column of weights is loaded once per tile
+    // of inputs. A tile goes through the chunks which are non-zero for any of its inputs,
+    // a chunk which is zero for some of them adds nothing to their sums.
+    void propagate_batch(const InputType* const*       inputs,
+                         OutputType* const*            outputs,
+                         const NNZInfo<InDims>* const* nnzInfos,
+                         IndexType                     count) const {
+        IndexType b = 0;
+
+#if (defined(USE_SSSE3) || defined(USE_LSX) || defined(USE_LASX) || (USE_NEON >= 8))
+    #if defined(USE_AVX512)
+        using invec_t  = __m512i;
+        using outvec_t = __m512i;
+        #define vec_set_32 _mm512_set1_epi32
+        #define vec_add_dpbusd_32 SIMD::m512_add_dpbusd_epi32
+    #elif defined(USE_AVX2)
+        using invec_t  = __m256i;
+        using outvec_t = __m256i;
+        #define vec_set_32 _mm256_set1_epi32
+        #define vec_add_dpbusd_32 SIMD::m256_add_dpbusd_epi32
+    #elif defined(USE_SSSE3)
+        using invec_t  = __m128i;
+        using outvec_t = __m128i;
+        #define vec_set_32 _mm_set1_epi32
+        #define vec_add_dpbusd_32 SIMD::m128_add_dpbusd_epi32
+    #elif defined(USE_NEON_DOTPROD)
+        using invec_t  = int8x16_t;
+        using outvec_t = int32x4_t;
+        #define vec_set_32(a) vreinterpretq_s8_u32(vdupq_n_u32(a))
+        #define vec_add_dpbusd_32 SIMD::dotprod_m128_add_dpbusd_epi32
+    #elif defined(USE_NEON)
+        using invec_t  = int8x16_t;
+        using outvec_t = int32x4_t;
+        #define vec_set_32(a) vreinterpretq_s8_u32(vdupq_n_u32(a))
+        #define vec_add_dpbusd_32 SIMD::neon_m128_add_dpbusd_epi32
+    #elif defined(USE_LASX)
+        using invec_t  = __m256i;
+        using outvec_t = __m256i;
+        #define vec_set_32 __lasx_xvreplgr2vr_w
+        #define vec_add_dpbusd_32 SIMD::lasx_m256_add_dpbusd_epi32
+    #elif defined(USE_LSX)
+        using invec_t  = __m128i;
+        using outvec_t = __m128i;
+        #define vec_set_32 __lsx_vreplgr2vr_w
+        #define vec_add_dpbusd_32 SIMD::lsx_m128_add_dpbusd_epi32
+    #endif
+        constexpr IndexType OutputSimdWidth = sizeof(outvec_t) / sizeof(OutputType);
+        constexpr IndexType NumAccums       = OutputDimensions / OutputSimdWidth;
+        constexpr IndexType NumChunks       = InputDimensions / ChunkSize;
+        constexpr IndexType Tile            = std::max<IndexType>(1, 8 / NumAccums);
+        constexpr IndexType ColumnSize      = OutputDimensions * ChunkSize;
+
+        static_assert(NumChunks % 64 == 0);
+
+        const outvec_t* biasvec    = reinterpret_cast<const outvec_t*>(biases);
+        const i8*       weights_cp = weights;
+
+        for (; Tile > 1 && b + Tile <= count; b += Tile)
+        {
+            u64 nnz[NumChunks / 64] = {};
+            for (IndexType t = 0; t < Tile; ++t)
+    #if defined(USE_AVX512)
+                for (unsigned j = 0; j < nnzInfos[b + t]->count; ++j)
+                    nnz[nnzInfos[b + t]->nnz[j] / 64] |= u64(1) << (nnzInfos[b + t]->nnz[j] % 64);
+    #else
+                for (IndexType k = 0; k < NumChunks / 64; ++k)
+                    nnz[k] |= load_as<u64>(nnzInfos[b + t]->bitset + k * 8);
+    #endif
+
+            outvec_t acc[Tile][NumAccums];
+            for (IndexType t = 0; t < Tile; ++t)
+                for (IndexType l = 0; l < NumAccums; ++l)
+                    acc[t][l] = biasvec[l];
+
+            for (IndexType k = 0; k < NumChunks / 64; ++k)
+                for (u64 bits = nnz[k]; bits;)
+                {
+                    const isize i = k * 64 + pop_lsb(bits);
+                    const auto  col = reinterpret_cast<const invec_t*>(&weights_cp[i * ColumnSize]);
+
+                    invec_t in[Tile];
+                    for (IndexType t = 0; t < Tile; ++t)
+                        in[t] = vec_set_32(load_as<i32>(inputs[b + t] + i * sizeof(i32)));
+
+                    for (IndexType l = 0; l < NumAccums; ++l)
+                    {
+                        const invec_t w = col[l];
+                        for (IndexType t = 0; t < Tile; ++t)
+                            vec_add_dpbusd_32(acc[t][l], in[t], w);
+                    }
+                }
+
+            for (IndexType t = 0; t < Tile; ++t)
+                for (IndexType l = 0; l < NumAccums; ++l)
+                    reinterpret_cast<outvec_t*>(outputs[b + t])[l] = acc[t][l];
+        }
+
+    #undef vec_set_32
+    #undef vec_add_dpbusd_32
+#endif
+
+        for (; b < count; ++b)
+            propagate(inputs[b], outputs[b], *nnzInfos[b]);
+    }
+
    private:
     using BiasType   = OutputType;
     using WeightType = i8;
@@ -18,9 +18,15 @@
 
 #include "network.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <numeric>
 #include <optional>
 #include <type_traits>
 #include <vector>
@@ -29,6 +35,7 @@
 #include "../incbin/incbin.h"
 
 #include "../evaluate.h"
+#include "../memory.h"
 #include "../misc.h"
 #include "../position.h"
 #include "../types.h"
@@ -84,18 +91,52 @@ bool write_parameters(std::ostream& stream, const T& reference) {
 
 }  // namespace Detail
 
-void Network::load(const std::string& rootDirectory, std::string evalfilePath) {
+namespace {
+
+std::vector<std::string> net_directories(const std::string& rootDirectory) {
 #if defined(DEFAULT_NNUE_DIRECTORY)
-    std::vector<std::string> dirs = {"<internal>", "", rootDirectory,
-                                     stringify(DEFAULT_NNUE_DIRECTORY)};
+    return {"<internal>", "", rootDirectory, stringify(DEFAULT_NNUE_DIRECTORY)};
 #else
-    std::vector<std::string> dirs = {"<internal>", "", rootDirectory};
+    return {"<internal>", "", rootDirectory};
 #endif
+}
+
+// A file in the mapped format is a header followed by the Network object. The header is
+// padded, so that the network starts at an offset which is a multiple of any common page
+// size and can be mapped directly.
+constexpr u64   MappedMagic      = 0x50414D554E4E4653;  // "SFNNUMAP"
+constexpr u32   MappedVersion    = 1;
+constexpr usize MappedHeaderSize = 64 * 1024;
+
+struct MappedHeader {
+    u64 magic;
+    u32 version;
+    u32 hash;    // Network::hash
+    u32 layout;  // See layout_hash()
+    u32 littleEndian;
+    u64 networkBytes;
+};
+
+// Tells apart the builds which lay out the network differently in memory, or transform
+// the weights differently for their SIMD code
+constexpr u32 layout_hash() {
+    u32 h = u32(sizeof(Network)) ^ u32(alignof(Network)) << 24;
+
+    for (usize i : FeatureTransformer::PackusEpi16Order)
+        h = h * 31 + u32(i);
+
+    h = h * 31 + decltype(NetworkArchitecture::fc_0)::get_weight_index(4);
+    h = h * 31 + decltype(NetworkArchitecture::fc_1)::get_weight_index(4);
+    return h;
+}
 
+}  // namespace
+
+void Network::load(const std::string& rootDirectory, std::string evalfilePath) {
     if (evalfilePath.empty())
         evalfilePath = evalFile.defaultName;
 
-    for (const auto& directory : dirs)
+    for (const auto& directory : net_directories(rootDirectory))
     {
         if (std::string(evalFile.current) != evalfilePath)
         {
@@ -158,6 +199,72 @@ NetworkOutput Network::evaluate(const Position&    pos,
 }
 
 
+void Network::evaluate_batch(const Position* const* positions,
+                             usize                  count,
+                             AccumulatorStack&      accumulatorStack,
+                             AccumulatorCaches&     cache,
+                             NetworkOutput*         results) const {
+
+    constexpr u64 alignment = CacheLineSize;
+
+    alignas(alignment) TransformedFeatureType
+      transformedFeatures[MaxBatchSize * FeatureTransformer::BufferSize];
+
+    ASSERT_ALIGNED(transformedFeatures, alignment);
+
+    NNZInfo<L1>                 nnzInfo[MaxBatchSize];
+    NetworkArchitecture::Buffer buffers[MaxBatchSize];
+    i32                         psqt[MaxBatchSize], positional[MaxBatchSize];
+    usize                       batch[MaxBatchSize];
+    std::vector<usize>          order(count);
+
+    auto bucket_of = [&](usize i) { return (positions[i]->count<ALL_PIECES>() - 1) / 4; };
+
+    // Positions of the same stack are also ordered by king squares, so that the
+    // accumulators are mostly refreshed from cache entries of similar positions.
+    auto sort_key = [&](usize i) {
+        return bucket_of(i) * SQUARE_NB * SQUARE_NB
+             + positions[i]->square<KING>(WHITE) * SQUARE_NB + positions[i]->square<KING>(BLACK);
+    };
+
+    std::iota(order.begin(), order.end(), usize(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [&](usize a, usize b) { return sort_key(a) < sort_key(b); });
+
+    for (usize start = 0; start < count;)
+    {
+        const int bucket = bucket_of(order[start]);
+        usize     size   = 0;
+
+        for (; start < count && size < MaxBatchSize && bucket_of(order[start]) == bucket; ++start)
+        {
+            const Position& pos = *positions[order[start]];
+
+            accumulatorStack.reset();
+            psqt[size] = featureTransformer.transform(
+              pos, accumulatorStack, cache,
+              transformedFeatures + size * FeatureTransformer::BufferSize, bucket, nnzInfo[size]);
+            batch[size++] = order[start];
+        }
+
+        network[bucket].propagate_batch(transformedFeatures, nnzInfo, IndexType(size), buffers,
+                                        positional);
+
+        for (usize i = 0; i < size; ++i)
+            results[batch[i]] = {static_cast<Value>(psqt[i] / OutputScale),
+                                 static_cast<Value>(positional[i] / OutputScale)};
+    }
+}
+
+
+bool Network::is_loaded(std::string evalfilePath) const {
+    if (evalfilePath.empty())
+        evalfilePath = evalFile.defaultName;
+
+    return std::string(evalFile.current) == evalfilePath;
+}
+
+
 void Network::verify(std::string                                  evalfilePath,
                      const std::function<void(std::string_view)>& f) const {
     if (evalfilePath.empty())
@@ -227,7 +334,19 @@ NnueEvalTrace Network::trace_evaluate(const Position&    pos,
 
 void Network::load_user_net(const std::string& dir, const std::string& evalfilePath) {
     std::ifstream stream(dir + evalfilePath, std::ios::binary);
-    auto          description = load(stream);
+
+    if (read_mapped_header(stream))
+    {
+        if (read_mapped(stream))
+            evalFile.current = evalfilePath;
+
+        return;
+    }
+
+    stream.clear();
+    stream.seekg(0);
+
+    auto description = load(stream);
 
     if (description.has_value())
     {
@@ -269,6 +388,68 @@ void Network::load_internal() {
 void Network::initialize() { initialized = true; }
 
 
+// Writes to a new file and moves it into place, so that a network mapped from the same
+// path is never overwritten while in use.
+bool Network::save_mapped(const std::string& filename) const {
+    const std::string tmpPath = filename + ".tmp";
+
+    MappedHeader header{MappedMagic,  MappedVersion,         hash,
+                        layout_hash(), u32(IsLittleEndian), u64(sizeof(Network))};
+
+    std::vector<char> headerBytes(MappedHeaderSize, 0);
+    std::memcpy(headerBytes.data(), &header, sizeof(header));
+
+    std::ofstream stream(tmpPath, std::ios::binary);
+    stream.write(headerBytes.data(), std::streamsize(headerBytes.size()));
+    stream.write(reinterpret_cast<const char*>(this), std::streamsize(sizeof(Network)));
+    stream.close();
+
+    const bool saved = initialized && stream && std::rename(tmpPath.c_str(), filename.c_str()) == 0;
+
+    if (!saved)
+        std::remove(tmpPath.c_str());
+
+    sync_cout << (saved ? "Network saved successfully to " + filename + " in the mapped format"
+                        : "Failed to export a net")
+              << sync_endl;
+    return saved;
+}
+
+
+std::shared_ptr<const Network> Network::map(const std::string& rootDirectory,
+                                            const std::string& evalfilePath) const {
+    for (const auto& directory : net_directories(rootDirectory))
+    {
+        if (directory == "<internal>")
+            continue;
+
+        const std::string path = directory + evalfilePath;
+        std::ifstream     stream(path, std::ios::binary);
+
+        if (!read_mapped_header(stream))
+            continue;
+
+        void* mem = map_file(path, MappedHeaderSize, sizeof(Network), true);
+        if (!mem)
+            return nullptr;
+
+        std::shared_ptr<Network> net(std::launder(reinterpret_cast<Network*>(mem)),
+                                     [](Network* n) { unmap_file(n, sizeof(Network)); });
+
+        if (!net->initialized)
+            return nullptr;
+
+        // The mapping is private, only the pages written here become copies
+        net->evalFile.defaultName = evalFile.defaultName;
+        net->evalFile.current     = evalfilePath;
+
+        return net;
+    }
+
+    return nullptr;
+}
+
+
 bool Network::save(std::ostream&      stream,
                    const std::string& name,
                    const std::string& netDescription) const {
@@ -299,6 +480,40 @@ usize Network::get_content_hash() const {
     return h;
 }
 
+// Checks that the stream holds a network in the mapped format, written by a build with
+// the same layout
+bool Network::read_mapped_header(std::istream& stream) {
+    MappedHeader header{};
+
+    stream.seekg(0, std::ios::end);
+    const auto fileBytes = stream.tellg();
+
+    stream.seekg(0);
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    return stream && header.magic == MappedMagic && header.version == MappedVersion
+        && header.hash == hash && header.layout == layout_hash()
+        && header.littleEndian == u32(IsLittleEndian) && header.networkBytes == sizeof(Network)
+        && usize(fileBytes) == MappedHeaderSize + sizeof(Network);
+}
+
+
+// Reads a network in the mapped format where it cannot be mapped, which still saves the
+// decoding and transforming of the weights
+bool Network::read_mapped(std::istream& stream) {
+    auto image = std::make_unique<Network>(evalFile);
+
+    stream.seekg(MappedHeaderSize);
+    if (!stream.read(reinterpret_cast<char*>(image.get()), std::streamsize(sizeof(Network)))
+        || !image->initialized)
+        return false;
+
+    image->evalFile.defaultName = evalFile.defaultName;
+    *this                       = *image;
+    return true;
+}
+
+
 // Read network header
 bool Network::read_header(std::istream& stream, u32* hashValue, std::string* desc) const {
     u32 version, size;
@@ -354,4 +569,27 @@ bool Network::write_parameters(std::ostream& stream, const std::string& netDescr
     return bool(stream);
 }
 
+
+void EvalCache::resize(usize mbSize) {
+    const usize newCount = mbSize * 1024 * 1024 / sizeof(Entry);
+    if (newCount == count)
+        return;
+
+    aligned_large_pages_free(table);
+    table = nullptr;
+    count = 0;
+
+    if (newCount)
+    {
+        table = static_cast<Entry*>(aligned_large_pages_alloc(newCount * sizeof(Entry)));
+        if (!table)
+            return;
+
+        count = newCount;
+        clear();
+    }
+}
+
+void EvalCache::clear() { std::fill(table, table + count, Entry{}); }
+
 }  // namespace Stockfish::Eval::NNUE
@@ -28,6 +28,7 @@
 #include <tuple>
 
 #include "../types.h"
+#include "../memory.h"
 #include "../misc.h"
 #include "nnue_architecture.h"
 #include "nnue_feature_transformer.h"
@@ -44,6 +45,70 @@ struct AccumulatorCaches;
 
 using NetworkOutput = std::tuple<Value, Value>;
 
+// A small cache of the outputs of Network::evaluate() of one thread, keyed by the
+// position key. A hit skips the propagation through the layers and leaves the
+// accumulator of the position to a later evaluation that needs it. With size 0 the
+// cache is disabled and never hit.
+class EvalCache {
+   public:
+    struct Stats {
+        u64 probes = 0;
+        u64 hits   = 0;
+
+        Stats& operator+=(const Stats& other) {
+            probes += other.probes;
+            hits += other.hits;
+            return *this;
+        }
+    };
+
+    EvalCache() = default;
+    ~EvalCache() { aligned_large_pages_free(table); }
+
+    EvalCache(const EvalCache&)            = delete;
+    EvalCache& operator=(const EvalCache&) = delete;
+
+    // Sizes the cache in MiB, the entries are kept if the size is unchanged
+    void resize(usize mbSize);
+    void clear();
+
+    bool probe(Key key, NetworkOutput& output) {
+        if (!count)
+            return false;
+
+        ++stats.probes;
+
+        const Entry& entry = table[mul_hi64(key, count)];
+        if (entry.key != key)
+            return false;
+
+        ++stats.hits;
+        output = {entry.psqt, entry.positional};
+        return true;
+    }
+
+    void store(Key key, const NetworkOutput& output) {
+        if (count)
+            table[mul_hi64(key, count)] = {key, std::get<0>(output), std::get<1>(output)};
+    }
+
+    Stats stats;
+
+   private:
+    struct Entry {
+        Key   key;
+        Value psqt;
+        Value positional;
+    };
+
+    static_assert(sizeof(Entry) == 16, "Four entries per cache line");
+
+    // Allocated directly rather than as an array, which would place the entries after
+    // its size and split them across cache lines.
+    Entry* table = nullptr;
+    usize  count = 0;
+};
+
 // The network must be a trivial type, i.e. the memory must be in-line.
 // This is required to allow sharing the network via shared memory, as
 // there is no way to run destructors.
@@ -61,14 +126,37 @@ class Network {
     void load(const std::string& rootDirectory, std::string evalfilePath);
     bool save(const std::optional<std::string>& filename) const;
 
+    // The mapped format is the network as it is in memory, after the weights have been
+    // transformed for this build, behind a header. It can be used in place without any
+    // decoding, see map(), but only by builds with the same layout.
+    bool save_mapped(const std::string& filename) const;
+
+    // Maps a network saved by save_mapped(), searching the same directories as load().
+    // Returns nullptr if there is no such file or it cannot be mapped, the file is then
+    // left to load(), which can read the mapped format too.
+    std::shared_ptr<const Network> map(const std::string& rootDirectory,
+                                       const std::string& evalfilePath) const;
+
     usize get_content_hash() const;
 
     NetworkOutput evaluate(const Position&    pos,
                            AccumulatorStack&  accumulatorStack,
                            AccumulatorCaches& cache) const;
 
+    // Evaluates count independent positions, for scoring many positions offline. They
+    // are evaluated ordered by layer stack, up to MaxBatchSize positions of the same stack
+    // at a time, and the results are stored in the order of the positions.
+    void evaluate_batch(const Position* const* positions,
+                        usize                  count,
+                        AccumulatorStack&      accumulatorStack,
+                        AccumulatorCaches&     cache,
+                        NetworkOutput*         results) const;
+
+    static constexpr usize MaxBatchSize = NetworkArchitecture::MaxBatchSize;
 
     void verify(std::string evalfilePath, const std::function<void(std::string_view)>&) const;
+    // Whether the network of the given file is the one loaded, the default one if empty
+    bool is_loaded(std::string evalfilePath) const;
     NnueEvalTrace trace_evaluate(const Position&    pos,
                                  AccumulatorStack&  accumulatorStack,
                                  AccumulatorCaches& cache) const;
@@ -88,6 +176,9 @@ class Network {
     bool read_parameters(std::istream&, std::string&);
     bool write_parameters(std::ostream&, const std::string&) const;
 
+    bool read_mapped(std::istream&);
+    static bool read_mapped_header(std::istream&);
+
     // Input feature converter
     FeatureTransformer featureTransformer;
 
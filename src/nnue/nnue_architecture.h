@@ -21,6 +21,7 @@
 #ifndef NNUE_ARCHITECTURE_H_INCLUDED
 #define NNUE_ARCHITECTURE_H_INCLUDED
 
+#include <cassert>
 #include <cstdint>
 #include <cstring>
 #include <iosfwd>
@@ -58,6 +59,7 @@ struct NetworkArchitecture {
     static constexpr IndexType TransformedFeatureDimensions = L1;
     static constexpr int       FC_0_OUTPUTS                 = L2;
     static constexpr int       FC_1_OUTPUTS                 = L3;
+    static constexpr IndexType MaxBatchSize                 = 16;
 
     Layers::AffineTransformSparseInput<TransformedFeatureDimensions, FC_0_OUTPUTS + 1> fc_0;
     Layers::SqrClippedReLU<FC_0_OUTPUTS + 1, WeightScaleBits + 1>                      ac_sqr_0;
@@ -97,31 +99,99 @@ struct NetworkArchitecture {
             && fc_2.write_parameters(stream);
     }
 
+    struct alignas(CacheLineSize) Buffer {
+        alignas(CacheLineSize) typename decltype(fc_0)::OutputBuffer fc_0_out;
+        alignas(CacheLineSize) typename decltype(ac_sqr_0)::OutputType
+          ac_sqr_0_out[ceil_to_multiple<IndexType>(FC_0_OUTPUTS * 2, 32)];
+        alignas(CacheLineSize) typename decltype(ac_0)::OutputBuffer ac_0_out;
+        alignas(CacheLineSize) typename decltype(fc_1)::OutputBuffer fc_1_out;
+        alignas(CacheLineSize) typename decltype(ac_1)::OutputBuffer ac_1_out;
+        alignas(CacheLineSize) typename decltype(fc_2)::OutputBuffer fc_2_out;
+
+        Buffer() { std::memset(ac_sqr_0_out, 0, sizeof(ac_sqr_0_out)); }
+    };
+
     i32 propagate(const TransformedFeatureType* transformedFeatures,
                   const NNZInfo<L1>&            nnzInfo) const {
-        struct alignas(CacheLineSize) Buffer {
-            alignas(CacheLineSize) typename decltype(fc_0)::OutputBuffer fc_0_out;
-            alignas(CacheLineSize) typename decltype(ac_sqr_0)::OutputType
-              ac_sqr_0_out[ceil_to_multiple<IndexType>(FC_0_OUTPUTS * 2, 32)];
-            alignas(CacheLineSize) typename decltype(ac_0)::OutputBuffer ac_0_out;
-            alignas(CacheLineSize) typename decltype(fc_1)::OutputBuffer fc_1_out;
-            alignas(CacheLineSize) typename decltype(ac_1)::OutputBuffer ac_1_out;
-            alignas(CacheLineSize) typename decltype(fc_2)::OutputBuffer fc_2_out;
-
-            Buffer() { std::memset(ac_sqr_0_out, 0, sizeof(ac_sqr_0_out)); }
-        };
-
         Buffer buffer;
 
+        propagate_fc_0(transformedFeatures, nnzInfo, buffer);
+        fc_1.propagate(buffer.ac_sqr_0_out, buffer.fc_1_out);
+        ac_1.propagate(buffer.fc_1_out, buffer.ac_1_out);
+        fc_2.propagate(buffer.ac_1_out, buffer.fc_2_out);
+
+        return output_value(buffer);
+    }
+
+    // Like propagate(), for count positions whose transformed features follow each other
+    // in transformedFeatures. The positions go through one layer after the other, and the
+    // affine layers take them in tiles, so that a vector of weights is loaded once for all
+    // the positions of a tile, see AffineTransform::propagate_batch().
+    void propagate_batch(const TransformedFeatureType* transformedFeatures,
+                         const NNZInfo<L1>*            nnzInfo,
+                         IndexType                     count,
+                         Buffer*                       buffers,
+                         i32*                          output) const {
+        assert(count <= MaxBatchSize);
+
+        const TransformedFeatureType* fc_0_in[MaxBatchSize];
+        const NNZInfo<L1>*            fc_0_nnz[MaxBatchSize];
+        i32*                          fc_0_out[MaxBatchSize];
+        const u8*                     fc_1_in[MaxBatchSize];
+        i32*                          fc_1_out[MaxBatchSize];
+        const u8*                     fc_2_in[MaxBatchSize];
+        i32*                          fc_2_out[MaxBatchSize];
+
+        for (IndexType i = 0; i < count; ++i)
+        {
+            fc_0_in[i]  = transformedFeatures + i * TransformedFeatureDimensions;
+            fc_0_nnz[i] = &nnzInfo[i];
+            fc_0_out[i] = buffers[i].fc_0_out;
+            fc_1_in[i]  = buffers[i].ac_sqr_0_out;
+            fc_1_out[i] = buffers[i].fc_1_out;
+            fc_2_in[i]  = buffers[i].ac_1_out;
+            fc_2_out[i] = buffers[i].fc_2_out;
+        }
+
+        fc_0.propagate_batch(fc_0_in, fc_0_out, fc_0_nnz, count);
+        for (IndexType i = 0; i < count; ++i)
+            activate_fc_0(buffers[i]);
+        fc_1.propagate_batch(fc_1_in, fc_1_out, count);
+        for (IndexType i = 0; i < count; ++i)
+            ac_1.propagate(buffers[i].fc_1_out, buffers[i].ac_1_out);
+        fc_2.propagate_batch(fc_2_in, fc_2_out, count);
+        for (IndexType i = 0; i < count; ++i)
+            output[i] = output_value(buffers[i]);
+    }
+
+    usize get_content_hash() const {
+        usize h = 0;
+        hash_combine(h, fc_0.get_content_hash());
+        hash_combine(h, ac_sqr_0.get_content_hash());
+        hash_combine(h, ac_0.get_content_hash());
+        hash_combine(h, fc_1.get_content_hash());
+        hash_combine(h, ac_1.get_content_hash());
+        hash_combine(h, fc_2.get_content_hash());
+        hash_combine(h, get_hash_value());
+        return h;
+    }
+
+   private:
+    void propagate_fc_0(const TransformedFeatureType* transformedFeatures,
+                        const NNZInfo<L1>&            nnzInfo,
+                        Buffer&                       buffer) const {
         fc_0.propagate(transformedFeatures, buffer.fc_0_out, nnzInfo);
+        activate_fc_0(buffer);
+    }
+
+    void activate_fc_0(Buffer& buffer) const {
         ac_sqr_0.propagate(buffer.fc_0_out, buffer.ac_sqr_0_out);
         ac_0.propagate(buffer.fc_0_out, buffer.ac_0_out);
         std::memcpy(buffer.ac_sqr_0_out + FC_0_OUTPUTS, buffer.ac_0_out,
                     FC_0_OUTPUTS * sizeof(typename decltype(ac_0)::OutputType));
-        fc_1.propagate(buffer.ac_sqr_0_out, buffer.fc_1_out);
-        ac_1.propagate(buffer.fc_1_out, buffer.ac_1_out);
-        fc_2.propagate(buffer.ac_1_out, buffer.fc_2_out);
+    }
 
+    static i32 output_value(const Buffer& buffer) {
         // max value for fwdOut is (L1 + L3) * HiddenMaxVal * WeightMaxVal
         // for int8 activations and weights this is (L1 + L3) * 16129 making
         // fwdOut safe from overflow until (L1 + L3) > 133,144
@@ -137,18 +207,6 @@ struct NetworkArchitecture {
         i32 outputValue = static_cast<i32>((static_cast<i64>(fwdOut) * multiplier) / denominator);
         return outputValue;
     }
-
-    usize get_content_hash() const {
-        usize h = 0;
-        hash_combine(h, fc_0.get_content_hash());
-        hash_combine(h, ac_sqr_0.get_content_hash());
-        hash_combine(h, ac_0.get_content_hash());
-        hash_combine(h, fc_1.get_content_hash());
-        hash_combine(h, ac_1.get_content_hash());
-        hash_combine(h, fc_2.get_content_hash());
-        hash_combine(h, get_hash_value());
-        return h;
-    }
 };
 
 }  // namespace Stockfish::Eval::NNUE
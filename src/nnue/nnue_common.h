@@ -187,37 +187,93 @@ inline void write_little_endian(std::ostream& stream, const IntType* values, usi
 // Read N signed integers from the stream s, putting them in the array out.
 // The stream is assumed to be compressed using the signed LEB128 format.
 // See https://en.wikipedia.org/wiki/LEB128 for a description of the compression scheme.
-template<typename BufType, typename IntType, usize Count>
-inline void read_leb_128_detail(std::istream&               stream,
+// Most weights take one or two bytes, so 8 bytes at a time are checked for 8 values of
+// one byte or 4 values of two bytes, which are then decoded without branches.
+template<typename IntType, usize Count, usize BufSize>
+inline void read_leb_128_detail(std::istream&              stream,
                                 std::array<IntType, Count>& out,
                                 u32&                        bytes_left,
-                                BufType&                    buf,
-                                u32&                        buf_pos) {
+                                std::array<u8, BufSize>&    buf,
+                                u32&                        buf_pos,
+                                u32&                        buf_end) {
 
     static_assert(std::is_signed_v<IntType>, "Not implemented for unsigned types");
     static_assert(sizeof(IntType) <= 4, "Not implemented for types larger than 32 bit");
 
-    IntType result = 0;
-    usize   shift = 0, i = 0;
+    // The continuation bits of the first byte of each value, for 4 values of two bytes
+    const u64 TwoByteValues = IsLittleEndian ? 0x0080008000800080ULL : 0x8000800080008000ULL;
+
+    usize i = 0;
     while (i < Count)
     {
-        if (buf_pos == buf.size())
+        // Keep at least 8 bytes in the buffer, unless the stream has no more
+        if (buf_end - buf_pos < 8 && bytes_left > 0)
         {
-            stream.read(reinterpret_cast<char*>(buf.data()),
-                        std::min(usize(bytes_left), buf.size()));
+            std::memmove(buf.data(), buf.data() + buf_pos, buf_end - buf_pos);
+            buf_end -= buf_pos;
             buf_pos = 0;
+
+            const u32 n = std::min(bytes_left, u32(buf.size()) - buf_end);
+            stream.read(reinterpret_cast<char*>(buf.data() + buf_end), n);
+            bytes_left -= n;
+            buf_end += n;
         }
 
-        u8 byte = buf[buf_pos++];
-        --bytes_left;
-        result |= (byte & 0x7f) << (shift % 32);
-        shift += 7;
+        const u8* bytes = buf.data() + buf_pos;
 
-        if ((byte & 0x80) == 0)
+        if (buf_end - buf_pos >= 8 && Count - i >= 8)
         {
-            out[i++] = (shift >= 32 || (byte & 0x40) == 0) ? result : result | ~((1 << shift) - 1);
-            result   = 0;
-            shift    = 0;
+            u64 chunk;
+            std::memcpy(&chunk, bytes, 8);
+
+            const u64 continuation = chunk & 0x8080808080808080ULL;
+
+            if (continuation == 0)
+            {
+                for (usize j = 0; j < 8; ++j)
+                    out[i + j] = IntType(i8(u8(bytes[j] << 1)) >> 1);
+
+                i += 8;
+                buf_pos += 8;
+                continue;
+            }
+
+            if (continuation == TwoByteValues)
+            {
+                for (usize j = 0; j < 4; ++j)
+                {
+                    const u32 v = u32(bytes[2 * j] & 0x7f) | u32(bytes[2 * j + 1]) << 7;
+                    out[i + j]  = IntType(i32(v << 18) >> 18);
+                }
+
+                i += 4;
+                buf_pos += 8;
+                continue;
+            }
+        }
+
+        // Any other value, one byte at a time. It has at most 5 bytes, so it is in the
+        // buffer unless the data is truncated.
+        IntType result = 0;
+        usize   shift  = 0;
+        while (true)
+        {
+            if (buf_pos == buf_end)
+            {
+                stream.setstate(std::ios::failbit);
+                return;
+            }
+
+            u8 byte = buf[buf_pos++];
+            result |= (byte & 0x7f) << (shift % 32);
+            shift += 7;
+
+            if ((byte & 0x80) == 0)
+            {
+                out[i++] =
+                  (shift >= 32 || (byte & 0x40) == 0) ? result : result | ~((1 << shift) - 1);
+                break;
+            }
         }
     }
 }
@@ -229,13 +285,13 @@ inline void read_leb_128(std::istream& stream, Arrays&... outs) {
     stream.read(leb128MagicString, Leb128MagicStringSize);
     assert(strncmp(Leb128MagicString, leb128MagicString, Leb128MagicStringSize) == 0);
 
-    auto                 bytes_left = read_little_endian<u32>(stream);
-    std::array<u8, 8192> buf;
-    u32                  buf_pos = u32(buf.size());
+    auto                  bytes_left = read_little_endian<u32>(stream);
+    std::array<u8, 65536> buf;
+    u32                   buf_pos = 0, buf_end = 0;
 
-    (read_leb_128_detail(stream, outs, bytes_left, buf, buf_pos), ...);
+    (read_leb_128_detail(stream, outs, bytes_left, buf, buf_pos, buf_end), ...);
 
-    assert(bytes_left == 0);
+    assert(bytes_left == 0 && buf_pos == buf_end);
 }
 
 
@@ -26,6 +26,8 @@
 #include <cstring>
 #include <iosfwd>
 #include <iterator>
+#include <thread>
+#include <vector>
 
 #include "../position.h"
 #include "../types.h"
@@ -56,24 +58,44 @@ void permute(std::array<T, N>& data, const std::array<usize, OrderSize>& order)
 
     constexpr usize ProcessChunkSize = BlockSize * OrderSize;
 
-    std::array<std::byte, ProcessChunkSize> buffer{};
-
     std::byte* const bytes = reinterpret_cast<std::byte*>(data.data());
 
-    for (usize i = 0; i < TotalSize; i += ProcessChunkSize)
-    {
-        std::byte* const values = &bytes[i];
+    auto permute_range = [&](usize begin, usize end) {
+        std::array<std::byte, ProcessChunkSize> buffer{};
 
-        for (usize j = 0; j < OrderSize; j++)
+        for (usize i = begin; i < end; i += ProcessChunkSize)
         {
-            auto* const buffer_chunk = &buffer[j * BlockSize];
-            auto* const value_chunk  = &values[order[j] * BlockSize];
+            std::byte* const values = &bytes[i];
+
+            for (usize j = 0; j < OrderSize; j++)
+            {
+                auto* const buffer_chunk = &buffer[j * BlockSize];
+                auto* const value_chunk  = &values[order[j] * BlockSize];
 
-            std::copy(value_chunk, value_chunk + BlockSize, buffer_chunk);
+                std::copy(value_chunk, value_chunk + BlockSize, buffer_chunk);
+            }
+
+            std::copy(std::begin(buffer), std::end(buffer), values);
         }
+    };
 
-        std::copy(std::begin(buffer), std::end(buffer), values);
-    }
+    // Large arrays, like the threat weights, are shared out among threads, in ranges of
+    // at least 4 MiB
+    constexpr usize Chunks      = TotalSize / ProcessChunkSize;
+    const usize     threadCount = std::max<usize>(
+      1, std::min<usize>(std::thread::hardware_concurrency(), TotalSize / (4 << 20)));
+
+    auto range_start = [&](usize t) { return Chunks * t / threadCount * ProcessChunkSize; };
+
+    std::vector<std::thread> threads;
+
+    for (usize t = 1; t < threadCount; ++t)
+        threads.emplace_back(permute_range, range_start(t), range_start(t + 1));
+
+    permute_range(0, range_start(1));
+
+    for (auto& th : threads)
+        th.join();
 }
 
 // Input feature converter
@@ -1512,15 +1512,22 @@ class LazyNumaReplicatedSystemWide: public NumaReplicatedBase {
         prepare_replicate_from(std::move(source));
     }
 
+    LazyNumaReplicatedSystemWide(NumaReplicationContext& ctx, std::shared_ptr<const T> value) :
+        NumaReplicatedBase(ctx) {
+        use_mapped(std::move(value));
+    }
+
     LazyNumaReplicatedSystemWide(const LazyNumaReplicatedSystemWide&) = delete;
     LazyNumaReplicatedSystemWide(LazyNumaReplicatedSystemWide&& other) noexcept :
         NumaReplicatedBase(std::move(other)),
-        instances(std::exchange(other.instances, {})) {}
+        instances(std::exchange(other.instances, {})),
+        mapped(std::move(other.mapped)) {}
 
     LazyNumaReplicatedSystemWide& operator=(const LazyNumaReplicatedSystemWide&) = delete;
     LazyNumaReplicatedSystemWide& operator=(LazyNumaReplicatedSystemWide&& other) noexcept {
         NumaReplicatedBase::operator=(*this, std::move(other));
         instances = std::exchange(other.instances, {});
+        mapped    = std::move(other.mapped);
 
         return *this;
     }
@@ -1543,6 +1550,12 @@ class LazyNumaReplicatedSystemWide: public NumaReplicatedBase {
 
     const T* operator->() const { return &*instances[0]; }
 
+    // Replicates the value to all NUMA nodes now, instead of at their first access
+    void replicate_all() const {
+        for (NumaIndex idx = 1; idx < instances.size(); ++idx)
+            ensure_present(idx);
+    }
+
     std::vector<std::pair<SystemWideSharedConstantAllocationStatus, std::optional<std::string>>>
     get_status_and_errors() const {
         std::vector<std::pair<SystemWideSharedConstantAllocationStatus, std::optional<std::string>>>
@@ -1557,6 +1570,16 @@ class LazyNumaReplicatedSystemWide: public NumaReplicatedBase {
         return status;
     }
 
+    // Uses a value mapped from a file in place on all NUMA nodes, instead of replicating
+    // it. The nodes then share the pages of the file from the page cache.
+    void use_mapped(std::shared_ptr<const T> value) {
+        mapped = std::move(value);
+        instances.clear();
+
+        for (usize i = 0; i < get_numa_config().num_numa_nodes(); ++i)
+            instances.emplace_back(SystemWideSharedConstant<T>(mapped));
+    }
+
     template<typename FuncT>
     void modify_and_replicate(FuncT&& f) {
         auto source = std::make_unique<T>(*instances[0]);
@@ -1565,6 +1588,12 @@ class LazyNumaReplicatedSystemWide: public NumaReplicatedBase {
     }
 
     void on_numa_config_changed() override {
+        if (mapped)
+        {
+            use_mapped(mapped);
+            return;
+        }
+
         // Use the first one as the source. It doesn't matter which one we use,
         // because they all must be identical, but the first one is guaranteed to exist.
         auto source = std::make_unique<T>(*instances[0]);
@@ -1574,6 +1603,7 @@ class LazyNumaReplicatedSystemWide: public NumaReplicatedBase {
    private:
     mutable std::vector<SystemWideSharedConstant<T>> instances;
     mutable std::mutex                               mutex;
+    std::shared_ptr<const T>                         mapped;  // The source, if used in place
 
     usize get_discriminator(NumaIndex idx) const {
         const NumaConfig& cfg     = get_numa_config();
@@ -1606,6 +1636,7 @@ class LazyNumaReplicatedSystemWide: public NumaReplicatedBase {
 
     void prepare_replicate_from(std::unique_ptr<T>&& source) {
         instances.clear();
+        mapped.reset();
 
         const NumaConfig& cfg = get_numa_config();
         // We just need to make sure the first instance is there.
@@ -1631,6 +1662,56 @@ class LazyNumaReplicatedSystemWide: public NumaReplicatedBase {
     }
 };
 
+// Holds the current version of a replicated value, which can be replaced while others use
+// it, in the manner of read-copy-update. Readers take a reference to the current version
+// with get() and keep it for as long as they use it, checking version() where they can
+// switch to a new one. The versions replaced are freed by collect() once nobody holds them.
+// Any thread may collect, but only one may publish at a time, and operator* may not be
+// used while it does.
+template<typename T>
+class NumaReplicatedPublisher {
+   public:
+    using Replicas = LazyNumaReplicatedSystemWide<T>;
+
+    explicit NumaReplicatedPublisher(std::unique_ptr<Replicas>&& initial) :
+        current(std::move(initial)) {}
+
+    std::shared_ptr<const Replicas> get() const { return std::atomic_load(&current); }
+
+    u64 version() const { return published.load(std::memory_order_acquire); }
+
+    const Replicas& operator*() const { return *current; }
+    const Replicas* operator->() const { return current.get(); }
+
+    void publish(std::shared_ptr<Replicas> replicas) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            retired.push_back(std::atomic_exchange(&current, std::move(replicas)));
+        }
+        published.fetch_add(1, std::memory_order_release);
+        collect();
+    }
+
+    // A retired version cannot be taken anymore, so once nobody else holds it, it is
+    // safe to free.
+    void collect() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = retired.begin(); it != retired.end();)
+            it = it->use_count() == 1 ? retired.erase(it) : it + 1;
+    }
+
+    usize retired_count() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return retired.size();
+    }
+
+   private:
+    std::shared_ptr<Replicas>              current;
+    std::atomic<u64>                       published{0};
+    mutable std::mutex                     mutex;
+    std::vector<std::shared_ptr<Replicas>> retired;
+};
+
 class NumaReplicationContext {
    public:
     NumaReplicationContext(NumaConfig&& cfg) :
@@ -19,25 +19,116 @@
 #ifndef PERFT_H_INCLUDED
 #define PERFT_H_INCLUDED
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
 
+#include "memory.h"
+#include "misc.h"
 #include "movegen.h"
 #include "position.h"
+#include "thread.h"
 #include "types.h"
 #include "uci.h"
 
 namespace Stockfish::Benchmark {
 
+// A lock-free cache of leaf counts, indexed by position key and remaining depth. Each entry
+// stores the count next to its XOR with the key, so that entries torn by racing writes
+// are recognized on reading, as no valid pair of count and key can produce them.
+// The table uses the given memory, e.g. lent by the transposition table, or allocates
+// its own without.
+class PerftTable {
+   public:
+    PerftTable(usize bytes, void* mem) :
+        entryCount(bytes / sizeof(Entry)),
+        entries(static_cast<Entry*>(mem ? mem : aligned_large_pages_alloc(bytes))),
+        owned(!mem) {}
+
+    ~PerftTable() {
+        if (owned)
+            aligned_large_pages_free(entries);
+    }
+
+    PerftTable(const PerftTable&)            = delete;
+    PerftTable& operator=(const PerftTable&) = delete;
+
+    bool probe(Key key, Depth depth, u64& nodes) const {
+        const Entry& e     = entry(key, depth);
+        const u64    count = e.nodes;
+
+        if ((e.check ^ count) != mix(key, depth))
+            return false;
+
+        nodes = count;
+        return true;
+    }
+
+    void store(Key key, Depth depth, u64 nodes) {
+        Entry& e = entry(key, depth);
+        e.check  = mix(key, depth) ^ nodes;
+        e.nodes  = nodes;
+    }
+
+    // Zeroes the table, multithreaded
+    void clear(ThreadPool& threads) {
+        const usize threadCount = threads.num_threads();
+
+        for (usize i = 0; i < threadCount && entries; ++i)
+            threads.run_on_thread(i, [this, i, threadCount]() {
+                const usize stride = entryCount / threadCount;
+                const usize start  = stride * i;
+                const usize len    = i + 1 != threadCount ? stride : entryCount - start;
+
+                std::memset(static_cast<void*>(&entries[start]), 0, len * sizeof(Entry));
+            });
+
+        for (usize i = 0; i < threadCount; ++i)
+            threads.wait_on_thread(i);
+    }
+
+    usize size() const { return entries ? entryCount : 0; }
+
+   private:
+    struct Entry {
+        RelaxedAtomic<u64> check;
+        RelaxedAtomic<u64> nodes;
+    };
+
+    static Key mix(Key key, Depth depth) { return key ^ (u64(depth) * 0x9E3779B97F4A7C15ULL); }
+
+    Entry& entry(Key key, Depth depth) const {
+        return entries[mul_hi64(mix(key, depth), entryCount)];
+    }
+
+    usize  entryCount;
+    Entry* entries;
+    bool   owned;
+};
+
 // Utility to verify move generation. All the leaf nodes up
 // to the given depth are generated and counted, and the sum is returned.
 template<bool Root>
-u64 perft(Position& pos, Depth depth) {
+u64 perft(Position& pos, Depth depth, PerftTable* table = nullptr) {
 
     StateInfo st;
 
     u64        cnt, nodes = 0;
     const bool leaf = (depth == 2);
 
+    if (!Root && table && table->probe(pos.key(), depth, nodes))
+        return nodes;
+
     for (const auto& m : MoveList<LEGAL>(pos))
     {
         if (Root && depth <= 1)
@@ -45,22 +136,245 @@ u64 perft(Position& pos, Depth depth) {
         else
         {
             pos.do_move(m, st);
-            cnt = leaf ? MoveList<LEGAL>(pos).size() : perft<false>(pos, depth - 1);
+            cnt = leaf ? MoveList<LEGAL>(pos).size() : perft<false>(pos, depth - 1, table);
             nodes += cnt;
             pos.undo_move(m);
         }
         if (Root)
             sync_cout << UCIEngine::move(m, pos.is_chess960()) << ": " << cnt << sync_endl;
     }
+
+    if (!Root && table)
+        table->store(pos.key(), depth, nodes);
+
     return nodes;
 }
 
-inline u64 perft(const std::string& fen, Depth depth, bool isChess960) {
+// Parallel perft of the given position, using the threads of the pool and a table of `bytes`
+// shared by all of them, see PerftTable. The work is split two plies below the root, so that
+// there are enough tasks for many threads. The per move counts are only printed once all are
+// known, in move generation order, so that the output does not depend on the thread count.
+inline u64 perft(const std::string& fen,
+                 Depth              depth,
+                 bool               isChess960,
+                 ThreadPool&        threads,
+                 usize              bytes,
+                 void*              mem = nullptr) {
+
     StateInfo st;
-    Position  p;
-    p.set(fen, isChess960, &st);
+    Position  root;
+    root.set(fen, isChess960, &st);
+
+    if (depth < 3)
+        return perft<true>(root, depth);
+
+    const usize threadCount = threads.num_threads();
+    PerftTable  table(bytes, mem);
+
+    table.clear(threads);
+
+    // Each task is a pair of a root move and a reply to it
+    const MoveList<LEGAL>              rootMoves(root);
+    std::vector<std::pair<Move, Move>> tasks;
+    std::vector<usize>                 taskRootIndex;
+
+    for (usize n = 0; n < rootMoves.size(); ++n)
+    {
+        StateInfo st1;
+        root.do_move(rootMoves.begin()[n], st1);
+
+        for (const auto& m : MoveList<LEGAL>(root))
+        {
+            tasks.emplace_back(rootMoves.begin()[n], m);
+            taskRootIndex.push_back(n);
+        }
+
+        root.undo_move(rootMoves.begin()[n]);
+    }
+
+    std::vector<std::atomic<u64>> counts(rootMoves.size());
+    std::atomic<usize>            next = 0;
+
+    for (usize i = 0; i < threadCount; ++i)
+        threads.run_on_thread(i, [&]() {
+            StateInfo st0, st1, st2;
+            Position  pos;
+            pos.set(fen, isChess960, &st0);
+
+            for (usize n; (n = next++) < tasks.size();)
+            {
+                const auto [m1, m2] = tasks[n];
+
+                pos.do_move(m1, st1);
+                pos.do_move(m2, st2);
+
+                counts[taskRootIndex[n]] += depth == 3 ? MoveList<LEGAL>(pos).size()
+                                          : perft<false>(pos, depth - 2,
+                                                         table.size() ? &table : nullptr);
+
+                pos.undo_move(m2);
+                pos.undo_move(m1);
+            }
+        });
+
+    for (usize i = 0; i < threadCount; ++i)
+        threads.wait_on_thread(i);
+
+    u64 nodes = 0;
+
+    for (usize n = 0; n < rootMoves.size(); ++n)
+    {
+        sync_cout << UCIEngine::move(rootMoves.begin()[n], isChess960) << ": " << counts[n]
+                  << sync_endl;
+        nodes += counts[n];
+    }
+
+    return nodes;
+}
+
+// Runs the perft checks of an EPD file, whose lines are a FEN followed by the expected
+// counts, e.g. 'rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1 20 ;D2 400'.
+// The checks run in parallel, each on one thread, sharing a perft hash of `bytes`, see
+// PerftTable. Mismatches are reported in file order. Returns whether all checks passed.
+inline bool perft_suite(const std::string& file,
+                        bool               isChess960,
+                        ThreadPool&        threads,
+                        usize              bytes,
+                        void*              mem = nullptr) {
+
+    struct Check {
+        usize       line;
+        std::string fen;
+        Depth       depth;
+        u64         expected, found;
+    };
+
+    std::ifstream stream(file);
+    if (!stream)
+    {
+        sync_cout << "Unable to open file " << file << sync_endl;
+        return false;
+    }
+
+    std::vector<Check> checks;
+    usize              lineNumber = 0, positions = 0, errors = 0;
+
+    // Only whole numbers are accepted, e.g. 'D1x' is not
+    auto parse = [](std::string_view str, auto& value) {
+        const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        return ec == std::errc() && ptr == str.data() + str.size();
+    };
+
+    for (std::string line; std::getline(stream, line);)
+    {
+        const auto fields = split(line, ";");
+        auto       fen    = std::string(fields[0]);
+
+        ++lineNumber;
+        fen.erase(fen.find_last_not_of(" \t\r") + 1);
+
+        if (fen.empty() || fen[0] == '#')
+            continue;
+
+        StateInfo st;
+        Position  pos;
+
+        if (auto err = pos.set(fen, isChess960, &st))
+        {
+            sync_cout << "Invalid position on line " << lineNumber << ": " << err->what()
+                      << sync_endl;
+            ++errors;
+            continue;
+        }
+
+        ++positions;
+
+        for (usize i = 1; i < fields.size(); ++i)
+        {
+            std::string operation(fields[i]);
+            operation.erase(operation.find_last_not_of(" \t\r") + 1);
+
+            std::istringstream is(operation);
+            std::string        token, count;
+            int                depth    = 0;
+            u64                expected = 0;
+
+            // Other operations, e.g. 'id', are ignored
+            if (!(is >> token) || token[0] != 'D')
+                continue;
+
+            if (!parse(std::string_view(token).substr(1), depth) || depth < 0 || depth >= MAX_PLY
+                || !(is >> count) || !parse(count, expected))
+            {
+                sync_cout << "Malformed check on line " << lineNumber << ": " << operation
+                          << sync_endl;
+                ++errors;
+                continue;
+            }
+
+            checks.push_back({lineNumber, fen, Depth(depth), expected, 0});
+        }
+    }
+
+    // Start with the biggest checks, so that no thread is left with a long one at the end
+    std::vector<usize> order(checks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&checks](usize a, usize b) {
+        return checks[a].expected > checks[b].expected;
+    });
+
+    const TimePoint    start = now();
+    PerftTable         table(bytes, mem);
+    std::atomic<usize> next = 0;
+
+    table.clear(threads);
+
+    for (usize i = 0; i < threads.num_threads(); ++i)
+        threads.run_on_thread(i, [&]() {
+            for (usize n; (n = next++) < order.size();)
+            {
+                Check&    check = checks[order[n]];
+                StateInfo st;
+                Position  pos;
+
+                pos.set(check.fen, isChess960, &st);
+
+                check.found = check.depth <= 0 ? 1
+                            : check.depth == 1 ? MoveList<LEGAL>(pos).size()
+                                               : perft<false>(pos, check.depth,
+                                                              table.size() ? &table : nullptr);
+            }
+        });
+
+    for (usize i = 0; i < threads.num_threads(); ++i)
+        threads.wait_on_thread(i);
+
+    const TimePoint elapsed = std::max<TimePoint>(now() - start, 1);
+    u64             nodes   = 0;
+    usize           failed  = 0;
+
+    for (const Check& check : checks)
+    {
+        nodes += check.found;
+
+        if (check.found != check.expected)
+        {
+            sync_cout << "Mismatch on line " << check.line << " at depth " << check.depth
+                      << ": expected " << check.expected << ", found " << check.found << "\n"
+                      << check.fen << sync_endl;
+            ++failed;
+        }
+    }
+
+    sync_cout << "\n==========================="
+              << "\nPositions       : " << positions  //
+              << "\nChecks          : " << checks.size()
+              << "\nMismatches      : " << failed + errors
+              << "\nTotal time (ms) : " << elapsed  //
+              << "\nLeaf nodes      : " << nodes
+              << "\nNodes/second    : " << 1000 * nodes / elapsed << sync_endl;
 
-    return perft<true>(p, depth);
+    return failed + errors == 0;
 }
 }
 
@@ -35,6 +35,7 @@
 #include "bitboard.h"
 #include "evaluate.h"
 #include "history.h"
+#include "memory.h"
 #include "misc.h"
 #include "movegen.h"
 #include "movepick.h"
@@ -174,20 +175,42 @@ Search::Worker::Worker(SharedState&                    sharedState,
     options(sharedState.options),
     threads(sharedState.threads),
     tt(sharedState.tt),
-    network(sharedState.network),
-    refreshTable(network[token]) {
-    clear();
+    networks(sharedState.network),
+    networkVersion(networks.version()),
+    network(networks.get()),
+    refreshTable((*network)[token]) {
+    clear_own_histories();
 }
 
 void Search::Worker::ensure_network_replicated() {
+    update_network();
+
     // Access once to force lazy initialization.
     // We do this because we want to avoid initialization during search.
-    (void) (network[numaAccessToken]);
+    (void) ((*network)[numaAccessToken]);
+}
+
+void Search::Worker::update_network() {
+    if (networks.version() == networkVersion)
+        return;
+
+    // The version is read first, so a network published meanwhile is not missed
+    networkVersion = networks.version();
+    network        = networks.get();
+
+    refreshTable.clear((*network)[numaAccessToken]);
+    accumulatorStack.reset();
+    evalCache.clear();
 }
 
 void Search::Worker::start_searching() {
 
+    update_network();
     accumulatorStack.reset();
+    TTStats::current = &ttStats;
+
+    if constexpr (TTStats::Enabled)
+        TTStats::currentNode = current_numa_node();
 
     // Non-main threads go directly to iterative_deepening()
     if (!is_mainthread())
@@ -208,9 +231,22 @@ void Search::Worker::start_searching() {
         return;
     }
 
-    // Main thread starts non-main threads, and begins own search.
+    // Main thread starts non-main threads, and begins own search. With 'go mate' the
+    // main thread searches a first iteration, so that it has a searched move whenever
+    // it is stopped, then runs the mate solver. It only continues its alpha-beta search
+    // if the solver proves that there is no mate, or its share of the time is over.
     threads.start_searching();
-    bool uciPvSent = iterative_deepening();
+
+    const bool useMateSolver =
+      limits.mate && int(options["MateHash"]) && int(options["MultiPV"]) == 1;
+    bool uciPvSent = useMateSolver && iterative_deepening(1);
+
+    const bool mateFound = useMateSolver && !threads.stop && solve_mate();
+
+    if (mateFound)
+        uciPvSent = true;
+    else if (!threads.stop)
+        uciPvSent = iterative_deepening();
 
     // When we reach the maximum depth, we can arrive here without a raise of
     // threads.stop. However, if we are pondering or in an infinite search,
@@ -237,7 +273,7 @@ void Search::Worker::start_searching() {
     Skill   skill =
       Skill(options["Skill Level"], options["UCI_LimitStrength"] ? int(options["UCI_Elo"]) : 0);
 
-    if (!limits.depth && !skill.enabled())
+    if (!limits.depth && !skill.enabled() && !mateFound)
         bestThread = threads.get_best_thread()->worker.get();
 
     main_manager()->bestPreviousScore        = bestThread->rootMoves[0].score;
@@ -260,10 +296,59 @@ void Search::Worker::start_searching() {
     main_manager()->updates.onBestmove(bestmove, ponder);
 }
 
+// Runs the mate solver for 'go mate' on the main thread. If it finds a mate, the
+// mating line becomes the PV of the first root move and is reported like a
+// completed iteration. Returns false if there is no mate or the search was stopped.
+// With a time limit, the solver gets half of the time, so that the alpha-beta search
+// which follows it has the rest to find a move.
+bool Search::Worker::solve_mate() {
+
+    Mate::Solver& solver = main_manager()->mateSolver;
+    solver.resize(usize(options["MateHash"]));
+
+    std::vector<Move> moves, pv;
+
+    for (const auto& rm : rootMoves)
+        moves.push_back(rm.pv[0]);
+
+    const TimePoint share = limits.movetime              ? limits.movetime / 2
+                          : limits.use_time_management() ? main_manager()->tm.optimum() / 2
+                                                         : 0;
+
+    const auto stop = [this, share]() {
+        main_manager()->check_time(*this);
+        return threads.stop || (share && main_manager()->tm.elapsed_time() >= share);
+    };
+
+    const auto result = solver.solve(rootPos, moves, limits.mate, nodes, stop, pv);
+
+    if (result != Mate::Solver::MATE)
+        return false;
+
+    auto it = std::find(rootMoves.begin(), rootMoves.end(), pv[0]);
+    std::rotate(rootMoves.begin(), it, it + 1);
+
+    RootMove& rm = rootMoves[0];
+
+    rm.score = rm.uciScore = rm.averageScore = mate_in(solver.mate_plies());
+    rm.selDepth                              = int(pv.size());
+    rm.unset_bound_flags();
+    rm.pv.clear();
+
+    for (Move m : pv)
+        rm.pv.push_back(m);
+
+    rootDepth = solver.mate_plies();
+    main_manager()->pv(*this, threads, tt, rootDepth);
+
+    return true;
+}
+
 // Main iterative deepening loop. It calls search()
 // repeatedly with increasing depth until the allocated thinking time has been
 // consumed, the user stops the search, or the maximum search depth is reached.
-bool Search::Worker::iterative_deepening() {
+// With maxDepth the loop ends at that depth, and a later call continues from it.
+bool Search::Worker::iterative_deepening(Depth maxDepth) {
 
     SearchManager* mainThread = (is_mainthread() ? main_manager() : nullptr);
 
@@ -319,18 +404,24 @@ bool Search::Worker::iterative_deepening() {
     int  searchAgainCounter = 0;
     bool uciPvSent          = false;
 
-    lowPlyHistory.fill(100);
+    if (!rootDepth)
+    {
+        lowPlyHistory.fill(100);
 
-    for (Color c : {WHITE, BLACK})
-        for (int i = 0; i < UINT_16_HISTORY_SIZE; i++)
-            mainHistory[c][i] = mainHistory[c][i] * 789 / 1024;
+        for (Color c : {WHITE, BLACK})
+            for (int i = 0; i < UINT_16_HISTORY_SIZE; i++)
+                mainHistory[c][i] = mainHistory[c][i] * 789 / 1024;
+    }
 
     // Iterative deepening loop until requested to stop or the target depth is reached
-    while (rootDepth + 1 < MAX_PLY && !threads.stop
+    while (rootDepth + 1 < MAX_PLY && rootDepth < maxDepth && !threads.stop
            && !(limits.depth && mainThread && rootDepth >= limits.depth))
     {
         rootDepth++;
 
+        // A network loaded during the search is used from this iteration on
+        update_network();
+
         // Age out PV variability metric and signal the start of a new iteration.
         if (mainThread)
         {
@@ -671,12 +762,19 @@ void Search::Worker::undo_null_move(Position& pos) { pos.undo_null_move(); }
 
 // Reset histories, usually before a new game
 void Search::Worker::clear() {
-    mainHistory.fill(-5);
-    captureHistory.fill(-699);
+    clear_own_histories();
+    clear_shared_histories();
+}
 
-    // Each thread is responsible for clearing their part of shared history
+// Each thread is responsible for clearing their part of shared history
+void Search::Worker::clear_shared_histories() {
     sharedHistory.correctionHistory.clear_range(-6, numaThreadIdx, numaTotal);
     sharedHistory.pawnHistory.clear_range(-1262, numaThreadIdx, numaTotal);
+}
+
+void Search::Worker::clear_own_histories() {
+    mainHistory.fill(-5);
+    captureHistory.fill(-699);
 
     ttMoveHistory = 0;
 
@@ -693,7 +791,7 @@ void Search::Worker::clear() {
     for (usize i = 1; i < reductions.size(); ++i)
         reductions[i] = int(2834 / 128.0 * std::log(i));
 
-    refreshTable.clear(network[numaAccessToken]);
+    refreshTable.clear((*network)[numaAccessToken]);
 }
 
 
@@ -796,6 +894,12 @@ Value Search::Worker::search(
     excludedMove                   = ss->excludedMove;
     posKey                         = pos.key();
     auto [ttHit, ttData, ttWriter] = tt.probe(posKey);
+
+    // A move which is not even pseudo-legal reveals a key collision
+    if constexpr (TTStats::Enabled)
+        if (ttHit && ttData.move && !pos.pseudo_legal(ttData.move))
+            ++ttStats.falseHits;
+
     // Need further processing of the saved data
     ss->ttHit    = ttHit;
     ttData.move  = rootNode ? rootMoves[pvIdx].pv[0] : ttHit ? ttData.move : Move::none();
@@ -1643,6 +1747,11 @@ Value Search::Worker::qsearch(Position& pos, Stack* ss, Value alpha, Value beta)
     // Step 3. Transposition table lookup
     posKey                         = pos.key();
     auto [ttHit, ttData, ttWriter] = tt.probe(posKey);
+
+    if constexpr (TTStats::Enabled)
+        if (ttHit && ttData.move && !pos.pseudo_legal(ttData.move))
+            ++ttStats.falseHits;
+
     // Need further processing of the saved data
     ss->ttHit    = ttHit;
     ttData.move  = ttHit ? ttData.move : Move::none();
@@ -1841,8 +1950,8 @@ TimePoint Search::Worker::elapsed() const {
 }
 
 Value Search::Worker::evaluate(const Position& pos) {
-    return Eval::evaluate(network[numaAccessToken], pos, accumulatorStack, refreshTable,
-                          optimism[pos.side_to_move()]);
+    return Eval::evaluate((*network)[numaAccessToken], pos, accumulatorStack, refreshTable,
+                          evalCache, optimism[pos.side_to_move()]);
 }
 
 namespace {
@@ -2050,6 +2159,9 @@ void SearchManager::check_time(Search::Worker& worker) {
         dbg_print();
     }
 
+    if (updates.onTick)
+        updates.onTick();
+
     // We should not stop pondering until told so by the GUI
     if (ponder)
         return;
@@ -2217,6 +2329,9 @@ void SearchManager::pv(Search::Worker&           worker,
         Depth d = usePreviousScore ? std::max(1, depth - 1) : depth;
         Value v = usePreviousScore ? rootMoves[i].previousScore : rootMoves[i].uciScore;
 
+        // A search stopped before its first iteration has no previous PV, only the move
+        bool usePreviousPV = usePreviousScore && !rootMoves[i].previousPV.empty();
+
         if (v == -VALUE_INFINITE)
             v = VALUE_ZERO;
 
@@ -2229,14 +2344,6 @@ void SearchManager::pv(Search::Worker&           worker,
             && (!rootMoves[i].score_is_bound() || isTBScore))
             syzygy_extend_pv(worker.options, worker.limits, pos, rootMoves[i], v);
 
-        std::string pv;
-        for (Move m : usePreviousScore ? rootMoves[i].previousPV : rootMoves[i].pv)
-            pv += UCIEngine::move(m, pos.is_chess960()) + " ";
-
-        // Remove last whitespace
-        if (!pv.empty())
-            pv.pop_back();
-
         auto wdl   = worker.options["UCI_ShowWDL"] ? UCIEngine::wdl(v, pos) : "";
         auto bound = rootMoves[i].scoreLowerbound
                      ? "lowerbound"
@@ -2259,7 +2366,8 @@ void SearchManager::pv(Search::Worker&           worker,
         info.nodes     = nodes;
         info.nps       = nodes * 1000 / time;
         info.tbHits    = tbHits;
-        info.pv        = pv;
+        info.pv        = usePreviousPV ? &rootMoves[i].previousPV : &rootMoves[i].pv;
+        info.chess960  = pos.is_chess960();
         info.hashfull  = tt.hashfull();
 
         updates.onUpdateFull(info);
@@ -32,6 +32,7 @@
 #include <cstring>
 
 #include "history.h"
+#include "mate.h"
 #include "misc.h"
 #include "nnue/network.h"
 #include "nnue/nnue_accumulator.h"
@@ -40,6 +41,7 @@
 #include "score.h"
 #include "syzygy/tbprobe.h"
 #include "timeman.h"
+#include "tt.h"
 #include "types.h"
 
 namespace Stockfish {
@@ -51,7 +53,6 @@ enum NodeType {
     Root
 };
 
-class TranspositionTable;
 class ThreadPool;
 class OptionsMap;
 
@@ -180,22 +181,22 @@ struct LimitsType {
 // The UCI stores the uci options, thread pool, and transposition table.
 // This struct is used to easily forward data to the Search::Worker class.
 struct SharedState {
-    SharedState(const OptionsMap&                                        optionsMap,
-                ThreadPool&                                              threadPool,
-                TranspositionTable&                                      transpositionTable,
-                std::map<NumaIndex, SharedHistories>&                    sharedHists,
-                const LazyNumaReplicatedSystemWide<Eval::NNUE::Network>& net) :
+    SharedState(const OptionsMap&                                   optionsMap,
+                ThreadPool&                                         threadPool,
+                TranspositionTable&                                 transpositionTable,
+                std::map<NumaIndex, SharedHistories>&               sharedHists,
+                const NumaReplicatedPublisher<Eval::NNUE::Network>& net) :
         options(optionsMap),
         threads(threadPool),
         tt(transpositionTable),
         sharedHistories(sharedHists),
         network(net) {}
 
-    const OptionsMap&                                        options;
-    ThreadPool&                                              threads;
-    TranspositionTable&                                      tt;
-    std::map<NumaIndex, SharedHistories>&                    sharedHistories;
-    const LazyNumaReplicatedSystemWide<Eval::NNUE::Network>& network;
+    const OptionsMap&                                   options;
+    ThreadPool&                                         threads;
+    TranspositionTable&                                 tt;
+    std::map<NumaIndex, SharedHistories>&               sharedHistories;
+    const NumaReplicatedPublisher<Eval::NNUE::Network>& network;
 };
 
 class Worker;
@@ -222,7 +223,8 @@ struct InfoFull: InfoShort {
     usize            nodes;
     usize            nps;
     usize            tbHits;
-    std::string_view pv;
+    const PVMoves*   pv;  // Only valid during the callback
+    bool             chess960;
     int              hashfull;
 };
 
@@ -232,6 +234,16 @@ struct InfoIteration {
     usize            currmovenumber;
 };
 
+// Final result of one position of a batch analysis, see Engine::analyse()
+struct InfoAnalysis: InfoShort {
+    usize       index;  // Position number in the file, starting at 1
+    int         selDepth;
+    usize       timeMs;
+    usize       nodes;
+    std::string bestmove;
+    std::string pv;
+};
+
 // Skill structure is used to implement strength limit. If we have a UCI_Elo,
 // we convert it to an appropriate skill level, anchored to the Stash engine.
 // This method is based on a fit of the Elo results for games played between
@@ -268,12 +280,15 @@ class SearchManager: public ISearchManager {
     using UpdateFull     = std::function<void(const InfoFull&)>;
     using UpdateIter     = std::function<void(const InfoIteration&)>;
     using UpdateBestmove = std::function<void(std::string_view, std::string_view)>;
+    using UpdateTick     = std::function<void()>;
 
+    // onTick is optional, it is called from check_time() on the main thread
     struct UpdateContext {
         UpdateShort    onUpdateNoMoves;
         UpdateFull     onUpdateFull;
         UpdateIter     onIter;
         UpdateBestmove onBestmove;
+        UpdateTick     onTick;
     };
 
 
@@ -298,6 +313,8 @@ class SearchManager: public ISearchManager {
     Value                bestPreviousAverageScore;
     bool                 stopOnPonderhit;
 
+    Mate::Solver mateSolver;
+
     const UpdateContext& updates;
 };
 
@@ -318,9 +335,12 @@ class Worker {
            usize,
            NumaReplicatedAccessToken);
 
-    // Called at instantiation to initialize reductions tables.
     // Reset histories, usually before a new game.
     void clear();
+    // Resets the part of the histories shared on the NUMA node this thread is
+    // responsible for, which is given by its index among the threads of the node.
+    void clear_shared_histories();
+    void set_numa_thread_count(usize count) { numaTotal = count; }
 
     // Called when the program receives the UCI 'go' command.
     // It searches from the root position and outputs the "bestmove".
@@ -329,6 +349,9 @@ class Worker {
     bool is_mainthread() const { return threadIdx == 0; }
 
     void ensure_network_replicated();
+    // Switches to the network published last, if it is not the one in use. The search
+    // calls it at the root, where the accumulators can be recomputed.
+    void update_network();
 
     // Public because they need to be updatable by the stats
     ButterflyHistory mainHistory;
@@ -342,7 +365,12 @@ class Worker {
     ContinuationHistory (&continuationHistory)[2][2];
 
    private:
-    bool iterative_deepening();
+    // Called at instantiation to initialize reductions tables, and by clear().
+    // A new thread leaves the shared histories to the thread pool.
+    void clear_own_histories();
+
+    bool iterative_deepening(Depth maxDepth = MAX_PLY);
+    bool solve_mate();
 
     void do_move(Position& pos, const Move move, StateInfo& st, Stack* const ss);
     void
@@ -376,6 +404,7 @@ class Worker {
     usize              pvIdx, pvLast;
     RelaxedAtomic<u64> nodes, tbHits, bestMoveChanges;
     int                selDepth, nmpMinPly;
+    TTStats            ttStats;
 
     Value optimism[COLOR_NB];
 
@@ -398,14 +427,19 @@ class Worker {
 
     Tablebases::Config tbConfig;
 
-    const OptionsMap&                                        options;
-    ThreadPool&                                              threads;
-    TranspositionTable&                                      tt;
-    const LazyNumaReplicatedSystemWide<Eval::NNUE::Network>& network;
+    const OptionsMap&                                   options;
+    ThreadPool&                                         threads;
+    TranspositionTable&                                 tt;
+    const NumaReplicatedPublisher<Eval::NNUE::Network>& networks;
+
+    // The network in use, kept alive by the worker until it switches to a newer one
+    u64                                                                     networkVersion;
+    std::shared_ptr<const LazyNumaReplicatedSystemWide<Eval::NNUE::Network>> network;
 
     // Used by NNUE
     Eval::NNUE::AccumulatorStack  accumulatorStack;
     Eval::NNUE::AccumulatorCaches refreshTable;
+    Eval::NNUE::EvalCache         evalCache;
 
     friend class Stockfish::ThreadPool;
     friend class SearchManager;
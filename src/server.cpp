@@ -0,0 +1,461 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server.h"
+
+#include <algorithm>
+
+#include "misc.h"
+
+#ifndef _WIN32
+    #include <atomic>
+    #include <cerrno>
+    #include <charconv>
+    #include <csignal>
+    #include <cstring>
+    #include <list>
+    #include <memory>
+    #include <optional>
+    #include <sstream>
+    #include <string_view>
+    #include <system_error>
+    #include <thread>
+    #include <utility>
+    #include <vector>
+
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+
+    #include "engine.h"
+    #include "search.h"
+    #include "uci.h"
+    #include "ucioption.h"
+#endif
+
+namespace Stockfish {
+
+usize CoreScheduler::acquire(usize wanted) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    ++active;
+
+    const usize fair = cores / active;
+    const usize free = cores > inUse ? cores - inUse : 0;
+    const usize n    = std::max<usize>(1, std::min({wanted, fair, free}));
+
+    inUse += n;
+
+    return n;
+}
+
+// More than all the cores are only reserved when nothing else runs
+void CoreScheduler::reserve(usize count) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    released.wait(lock, [&] { return inUse + count <= cores || !inUse; });
+
+    ++active;
+    inUse += count;
+}
+
+void CoreScheduler::release(usize granted) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        --active;
+        inUse -= granted;
+    }
+
+    released.notify_all();
+}
+
+#ifdef _WIN32
+
+bool Server::run(const std::string&) {
+    sync_cout << "info string The server needs Unix domain sockets" << sync_endl;
+    return false;
+}
+
+#else
+
+namespace {
+
+std::atomic<bool> stopRequested;
+
+extern "C" void on_stop_signal(int) { stopRequested = true; }
+
+// How often the server checks for signals
+constexpr int PollIntervalMs = 100;
+
+// How long a session keeps its threads, and their histories, after its last search
+constexpr int IdleTimeoutMs = 10000;
+
+// A UCI session on one connection. Its commands are read and executed on its own
+// thread, while search output is written by the search thread of its engine.
+class Session {
+   public:
+    Session(Engine& host, CoreScheduler& scheduler, int fd);
+    ~Session() { close(fd); }
+
+    void run();
+    bool finished() const { return done; }
+    void interrupt() { shutdown(fd, SHUT_RDWR); }
+
+   private:
+    bool execute(const std::string& cmd);
+    void go(std::istream& is);
+    void position(std::istream& is);
+    void setoption(std::istream& is);
+    template<typename F>
+    void configure(F&& f);
+
+    void send(std::string_view line);
+    void send_raw(std::string_view data);
+    void send_info_string(std::string_view str);
+
+    Engine            engine;
+    InfoOutput        output;
+    CoreScheduler&    scheduler;
+    const int         fd;
+    std::mutex        sendMutex;
+    std::atomic<bool> searching{false}, done{false};
+    usize             granted = 0;
+};
+
+Session::Session(Engine& host, CoreScheduler& coreScheduler, int socketFd) :
+    engine(host),
+    output(engine.get_options(), [this](std::string_view data) { send_raw(data); }),
+    scheduler(coreScheduler),
+    fd(socketFd) {
+
+    // By default the searches of a session may use all the cores of the server
+    engine.set_session_threads_default(scheduler.cores_count());
+
+    engine.get_options().add_info_listener([this](const std::optional<std::string>& str) {
+        if (str.has_value())
+            send_info_string(*str);
+    });
+
+    engine.set_on_update_no_moves(
+      [this](const Engine::InfoShort& info) { output.on_update_no_moves(info); });
+    engine.set_on_update_full(
+      [this](const Engine::InfoFull& info) { output.on_update_full(info); });
+    engine.set_on_iter([this](const Engine::InfoIter& info) { output.on_iter(info); });
+    engine.set_on_bestmove([this](std::string_view bestmove, std::string_view ponder) {
+        output.on_bestmove(bestmove, ponder);
+
+        // The threads of the engine are released by the session thread
+        scheduler.release(granted);
+        searching = false;
+    });
+    engine.set_on_verify_network([this](std::string_view str) { send_info_string(str); });
+    engine.set_on_tick([this]() { output.on_tick(); });
+}
+
+void Session::run() {
+    std::string buffer;
+    char        chunk[4096];
+    bool        quit = false;
+
+    while (!quit)
+    {
+        // An idle session gives back its threads after a while, they are created
+        // again by its next search
+        pollfd    pfd{fd, POLLIN, 0};
+        const int ready = poll(&pfd, 1, engine.search_threads() ? IdleTimeoutMs : -1);
+
+        if (ready == 0 && !searching)
+            engine.set_search_threads(0);
+
+        if (ready < 0 && errno != EINTR)
+            break;
+
+        if (ready <= 0)
+            continue;
+
+        const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            break;
+
+        buffer.append(chunk, usize(n));
+
+        for (usize end; !quit && (end = buffer.find('\n')) != std::string::npos;)
+        {
+            std::string cmd = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+
+            if (!cmd.empty() && cmd.back() == '\r')
+                cmd.pop_back();
+
+            quit = !execute(cmd);
+        }
+    }
+
+    engine.stop();
+    engine.wait_for_search_finished();
+
+    done = true;
+}
+
+// Returns false when the session ends
+bool Session::execute(const std::string& cmd) {
+    std::istringstream is(cmd);
+    std::string        token;
+
+    is >> token;
+
+    if (token == "quit")
+        return false;
+
+    else if (token == "stop")
+        engine.stop();
+
+    else if (token == "ponderhit")
+    {
+        if (searching)
+            engine.set_ponderhit(false);
+    }
+    else if (token == "uci")
+    {
+        std::ostringstream ss;
+        ss << "id name " << engine_info(true) << "\n" << engine.get_options() << "\nuciok";
+        send(ss.str());
+    }
+    else if (token == "isready")
+        send("readyok");
+    else if (token == "setoption")
+        setoption(is);
+    else if (token == "position")
+        position(is);
+    else if (token == "ucinewgame")
+        configure([this]() { engine.search_clear(); });
+    else if (token == "go")
+        go(is);
+    else if (!token.empty())
+        send_info_string("Unknown command: '" + cmd + "'");
+
+    return true;
+}
+
+void Session::go(std::istream& is) {
+    Search::LimitsType limits = UCIEngine::parse_limits(is);
+
+    if (limits.perft)
+    {
+        send_info_string("perft is not available in server sessions");
+        return;
+    }
+
+    if (searching)
+    {
+        send_info_string("A search is already running");
+        return;
+    }
+
+    granted = scheduler.acquire(usize(int(engine.get_options()["Threads"])));
+
+    // Usually the grant is that of the previous search, and its threads, still parked,
+    // search again. Otherwise only the difference is added or removed, see
+    // ThreadPool::resize().
+    if (engine.search_threads() != granted)
+        engine.set_search_threads(granted);
+
+    send_info_string(engine.thread_allocation_information_as_string());
+
+    searching = true;
+    engine.go(limits);
+}
+
+void Session::position(std::istream& is) {
+    std::string              fen;
+    std::vector<std::string> moves;
+
+    if (!UCIEngine::parse_position(is, fen, moves))
+        return;
+
+    engine.wait_for_search_finished();
+
+    if (auto err = engine.set_position(fen, moves))
+        send_info_string(std::string("Invalid position: ") + err->what());
+}
+
+// Threads is the maximum number of threads for the searches of the session, the
+// scheduler decides how many they actually get, see Session::go().
+void Session::setoption(std::istream& is) {
+    std::string token, name, value;
+
+    is >> token;  // Consume the "name" token
+
+    while (is >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+
+    while (is >> token)
+        value += (value.empty() ? "" : " ") + token;
+
+    if (!engine.get_options().count(name))
+    {
+        send_info_string("No such option: " + name);
+        return;
+    }
+
+    // The option parses the value with std::stoi, which needs a number
+    if (UCIEngine::to_lower(name) == "threads")
+    {
+        int        n   = 0;
+        const auto res = std::from_chars(value.data(), value.data() + value.size(), n);
+
+        std::istringstream ss("name Threads value " + value);
+
+        if (res.ec == std::errc() && res.ptr == value.data() + value.size())
+            engine.get_options().setoption(ss);
+
+        if (int(engine.get_options()["Threads"]) != n)
+            send_info_string("Invalid value for Threads: " + value);
+
+        return;
+    }
+
+    configure([&]() {
+        std::istringstream ss("name " + name + " value " + value);
+        engine.get_options().setoption(ss);
+    });
+}
+
+// Options such as Hash and ucinewgame clear the table and histories on all the threads
+// of the session, which the scheduler counts as busy meanwhile. A session which gave
+// back its threads gets one for this.
+template<typename F>
+void Session::configure(F&& f) {
+    engine.wait_for_search_finished();
+
+    const usize count = std::max<usize>(engine.search_threads(), 1);
+
+    scheduler.reserve(count);
+
+    if (!engine.search_threads())
+        engine.set_search_threads(1);
+
+    f();
+    scheduler.release(count);
+}
+
+void Session::send(std::string_view line) { send_raw(std::string(line) + "\n"); }
+
+void Session::send_raw(std::string_view data) {
+    std::lock_guard<std::mutex> lock(sendMutex);
+
+    // A client that went away is noticed by the reader, so errors are ignored here
+    for (usize sent = 0; sent < data.size();)
+    {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            break;
+
+        sent += usize(n);
+    }
+}
+
+void Session::send_info_string(std::string_view str) {
+    for (auto& line : split(str, "\n"))
+        if (!is_whitespace(line))
+            send("info string " + std::string(line));
+}
+
+}  // namespace
+
+bool Server::run(const std::string& socketPath) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path))
+        return false;
+
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    const int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0)
+        return false;
+
+    // Remove the socket of a previous server, which would make bind() fail
+    unlink(socketPath.c_str());
+
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(listenFd, SOMAXCONN) != 0)
+    {
+        close(listenFd);
+        return false;
+    }
+
+    // Sessions use the network as it is now, so check it once for all of them
+    host.verify_network();
+
+    stopRequested     = false;
+    auto previousInt  = std::signal(SIGINT, on_stop_signal);
+    auto previousTerm = std::signal(SIGTERM, on_stop_signal);
+
+    std::list<std::pair<std::unique_ptr<Session>, std::thread>> sessions;
+
+    while (!stopRequested)
+    {
+        pollfd pfd{listenFd, POLLIN, 0};
+
+        if (poll(&pfd, 1, PollIntervalMs) > 0)
+        {
+            const int fd = accept(listenFd, nullptr, nullptr);
+
+            if (fd >= 0)
+            {
+                auto session = std::make_unique<Session>(host, scheduler, fd);
+                auto thread  = std::thread(&Session::run, session.get());
+
+                sessions.emplace_back(std::move(session), std::move(thread));
+            }
+        }
+
+        for (auto it = sessions.begin(); it != sessions.end();)
+            if (it->first->finished())
+            {
+                it->second.join();
+                it = sessions.erase(it);
+            }
+            else
+                ++it;
+    }
+
+    for (auto& [session, thread] : sessions)
+    {
+        session->interrupt();
+        thread.join();
+    }
+
+    sessions.clear();
+
+    std::signal(SIGINT, previousInt);
+    std::signal(SIGTERM, previousTerm);
+
+    close(listenFd);
+    unlink(socketPath.c_str());
+
+    return true;
+}
+
+#endif
+
+}  // namespace Stockfish
@@ -0,0 +1,77 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2026 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERVER_H_INCLUDED
+#define SERVER_H_INCLUDED
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include "types.h"
+
+namespace Stockfish {
+
+class Engine;
+
+// Shares a number of cores among the sessions of the server. A session asks for
+// cores when it starts a search and gives them back with its bestmove. Each search
+// gets its fair share of the cores at the time it starts, capped by the session's
+// Threads option, and always at least one. Short work which needs all the threads of
+// a session, e.g. clearing its hash, reserves them regardless of the fair share, but
+// waits until they are free.
+class CoreScheduler {
+   public:
+    explicit CoreScheduler(usize coreCount) :
+        cores(coreCount) {}
+
+    usize cores_count() const { return cores; }
+
+    usize acquire(usize wanted);
+    void  reserve(usize count);
+    void  release(usize granted);
+
+   private:
+    std::mutex              mutex;
+    std::condition_variable released;
+    usize                   cores;
+    usize      inUse  = 0;
+    usize      active = 0;
+};
+
+// Serves UCI sessions over a Unix domain socket, one per connection. The sessions
+// are engines of their own, with their own position, options and hash, but they share
+// the network, NUMA context and tablebases of the host engine.
+class Server {
+   public:
+    Server(Engine& hostEngine, usize cores) :
+        host(hostEngine),
+        scheduler(cores) {}
+
+    // Blocks until SIGINT or SIGTERM is received, returns false if the socket
+    // cannot be created.
+    bool run(const std::string& socketPath);
+
+   private:
+    Engine&       host;
+    CoreScheduler scheduler;
+};
+
+}  // namespace Stockfish
+
+#endif  // #ifndef SERVER_H_INCLUDED
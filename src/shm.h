@@ -154,7 +154,8 @@ inline std::string getExecutablePathHash() {
 enum class SystemWideSharedConstantAllocationStatus {
     NoAllocation,
     LocalMemory,
-    SharedMemory
+    SharedMemory,
+    MappedFile
 };
 
 #if defined(_WIN32)
@@ -508,6 +509,34 @@ struct SharedMemoryBackendFallback {
     LargePagePtr<T> fallback_object;
 };
 
+// A value used in place where it was mapped from a file. The pages are shared through the
+// page cache with all processes mapping the same file. The owner unmaps the file once the
+// last backend using it is gone.
+template<typename T>
+struct MappedFileBackend {
+    MappedFileBackend() = default;
+
+    explicit MappedFileBackend(std::shared_ptr<const T> value) :
+        mapped(std::move(value)) {}
+
+    void* get() const { return const_cast<T*>(mapped.get()); }
+
+    SystemWideSharedConstantAllocationStatus get_status() const {
+        return mapped == nullptr ? SystemWideSharedConstantAllocationStatus::NoAllocation
+                                 : SystemWideSharedConstantAllocationStatus::MappedFile;
+    }
+
+    std::optional<std::string> get_error_message() const {
+        if (mapped == nullptr)
+            return "Not initialized";
+
+        return std::nullopt;
+    }
+
+   private:
+    std::shared_ptr<const T> mapped;
+};
+
 // Platform-independent wrapper
 template<typename T>
 struct SystemWideSharedConstant {
@@ -562,6 +591,10 @@ struct SystemWideSharedConstant {
         }
     }
 
+    // Uses a value mapped from a file, see MappedFileBackend
+    explicit SystemWideSharedConstant(std::shared_ptr<const T> mapped) :
+        backend(MappedFileBackend<T>(std::move(mapped))) {}
+
     SystemWideSharedConstant(const SystemWideSharedConstant&)            = delete;
     SystemWideSharedConstant& operator=(const SystemWideSharedConstant&) = delete;
 
@@ -625,7 +658,55 @@ struct SystemWideSharedConstant {
           backend);
     }
 
-    std::variant<std::monostate, SharedMemoryBackend<T>, SharedMemoryBackendFallback<T>> backend;
+    std::variant<std::monostate,
+                 SharedMemoryBackend<T>,
+                 SharedMemoryBackendFallback<T>,
+                 MappedFileBackend<T>>
+      backend;
+};
+
+// A writable, zero-initialized region of runtime size, shared system-wide (for the single user)
+// under the given name. Processes opening the same name and size attach to the same memory,
+// which is released once the last of them detaches. There is no local fallback, so callers
+// must check is_valid().
+class SystemWideSharedRegion {
+   public:
+    SystemWideSharedRegion() = default;
+
+    SystemWideSharedRegion([[maybe_unused]] const std::string& name,
+                           [[maybe_unused]] usize              size) {
+#if defined(__linux__) && !defined(__ANDROID__)
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "/sf_region_%016" PRIx64 "_%zu", hash_string(name), size);
+        shm1 = shm::create_shared_region(buf, size);
+#endif
+    }
+
+    SystemWideSharedRegion(const SystemWideSharedRegion&)            = delete;
+    SystemWideSharedRegion& operator=(const SystemWideSharedRegion&) = delete;
+
+    SystemWideSharedRegion(SystemWideSharedRegion&&) noexcept            = default;
+    SystemWideSharedRegion& operator=(SystemWideSharedRegion&&) noexcept = default;
+
+#if defined(__linux__) && !defined(__ANDROID__)
+    void* get() const {
+        return is_valid() ? reinterpret_cast<void*>(const_cast<char*>(&shm1->get())) : nullptr;
+    }
+
+    bool is_valid() const { return shm1 && shm1->is_open() && shm1->is_initialized(); }
+
+    // Number of attached instances, including this one
+    u32 ref_count() const { return is_valid() ? shm1->ref_count() : 0; }
+
+   private:
+    std::optional<shm::SharedMemory<char>> shm1;
+#else
+    void* get() const { return nullptr; }
+
+    bool is_valid() const { return false; }
+
+    u32 ref_count() const { return 0; }
+#endif
 };
 
 
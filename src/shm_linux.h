@@ -23,6 +23,7 @@
     #error shm_linux.h should not be included on this platform.
 #endif
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cerrno>
@@ -154,12 +155,13 @@ class SharedMemory: public detail::SharedMemoryBase {
     void*              mapped_ptr_ = nullptr;
     T*                 data_ptr_   = nullptr;
     detail::ShmHeader* header_ptr_ = nullptr;
+    usize              data_size_  = sizeof(T);
     usize              total_size_ = 0;
     std::string        sentinel_base_;
     std::string        sentinel_path_;
 
-    static constexpr usize calculate_total_size() noexcept {
-        return sizeof(T) + sizeof(detail::ShmHeader);
+    static constexpr usize calculate_total_size(usize data_size) noexcept {
+        return data_size + sizeof(detail::ShmHeader);
     }
 
     static std::string make_sentinel_base(const std::string& name) {
@@ -173,7 +175,16 @@ class SharedMemory: public detail::SharedMemoryBase {
    public:
     explicit SharedMemory(const std::string& name) noexcept :
         name_(name),
-        total_size_(calculate_total_size()),
+        total_size_(calculate_total_size(data_size_)),
+        sentinel_base_(make_sentinel_base(name)) {}
+
+    // A region of `data_size` bytes (rounded up to keep the header aligned), of which
+    // the first sizeof(T) are initialized by open() and the remainder is zero-filled.
+    SharedMemory(const std::string& name, usize data_size) noexcept :
+        name_(name),
+        data_size_((std::max(data_size, sizeof(T)) + alignof(detail::ShmHeader) - 1)
+                   / alignof(detail::ShmHeader) * alignof(detail::ShmHeader)),
+        total_size_(calculate_total_size(data_size_)),
         sentinel_base_(make_sentinel_base(name)) {}
 
     ~SharedMemory() noexcept override {
@@ -190,6 +201,7 @@ class SharedMemory: public detail::SharedMemoryBase {
         mapped_ptr_(other.mapped_ptr_),
         data_ptr_(other.data_ptr_),
         header_ptr_(other.header_ptr_),
+        data_size_(other.data_size_),
         total_size_(other.total_size_),
         sentinel_base_(std::move(other.sentinel_base_)),
         sentinel_path_(std::move(other.sentinel_path_)) {
@@ -210,6 +222,7 @@ class SharedMemory: public detail::SharedMemoryBase {
             mapped_ptr_    = other.mapped_ptr_;
             data_ptr_      = other.data_ptr_;
             header_ptr_    = other.header_ptr_;
+            data_size_     = other.data_size_;
             total_size_    = other.total_size_;
             sentinel_base_ = std::move(other.sentinel_base_);
             sentinel_path_ = std::move(other.sentinel_path_);
@@ -370,6 +383,8 @@ class SharedMemory: public detail::SharedMemoryBase {
 
     [[nodiscard]] const T& operator*() const noexcept { return *data_ptr_; }
 
+    [[nodiscard]] usize data_size() const noexcept { return data_size_; }
+
     [[nodiscard]] u32 ref_count() const noexcept {
         return header_ptr_ ? header_ptr_->ref_count.load(std::memory_order_acquire) : 0;
     }
@@ -613,7 +628,7 @@ class SharedMemory: public detail::SharedMemoryBase {
 
         data_ptr_ = static_cast<T*>(mapped_ptr_);
         header_ptr_ =
-          reinterpret_cast<detail::ShmHeader*>(static_cast<char*>(mapped_ptr_) + sizeof(T));
+          reinterpret_cast<detail::ShmHeader*>(static_cast<char*>(mapped_ptr_) + data_size_);
 
         new (header_ptr_) detail::ShmHeader{};
         new (data_ptr_) T{initial_value};
@@ -650,7 +665,7 @@ class SharedMemory: public detail::SharedMemoryBase {
 
         data_ptr_   = static_cast<T*>(mapped_ptr_);
         header_ptr_ = std::launder(
-          reinterpret_cast<detail::ShmHeader*>(static_cast<char*>(mapped_ptr_) + sizeof(T)));
+          reinterpret_cast<detail::ShmHeader*>(static_cast<char*>(mapped_ptr_) + data_size_));
 
         if (!header_ptr_->initialized.load(std::memory_order_acquire)
             || header_ptr_->magic != detail::ShmHeader::SHM_MAGIC)
@@ -673,6 +688,15 @@ template<typename T>
     return std::nullopt;
 }
 
+// Opens or creates a zero-filled region of `size` bytes
+[[nodiscard]] inline std::optional<SharedMemory<char>> create_shared_region(const std::string& name,
+                                                                          usize size) noexcept {
+    SharedMemory<char> shm(name, size);
+    if (shm.open(0))
+        return shm;
+    return std::nullopt;
+}
+
 }  // namespace Stockfish::shm
 
 #endif  // #ifndef SHM_LINUX_H_INCLUDED
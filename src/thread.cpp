@@ -25,6 +25,7 @@
 #include <deque>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -43,8 +44,11 @@
 
 namespace Stockfish {
 
-// Constructor launches the thread and waits until it goes to sleep
-// in idle_loop(). Note that 'searching' and 'exit' should be already set.
+// Constructor launches the thread, which then constructs its worker, after binding
+// itself to its NUMA node so that the memory of the worker is first touched there.
+// The constructor does not wait for the worker, so that threads are constructed in
+// parallel: wait_for_search_finished() must be called before it is used. Note that
+// 'searching' and 'exit' should be already set.
 Thread::Thread(Search::SharedState&                    sharedState,
                std::unique_ptr<Search::ISearchManager> sm,
                usize                                   n,
@@ -59,16 +63,17 @@ Thread::Thread(Search::SharedState&                    sharedState,
 
     wait_for_search_finished();
 
-    run_custom_job([this, &binder, &sharedState, &sm, n]() {
+    // The job must be copyable, so it takes the search manager as a raw pointer. It
+    // is run before anything else on this thread, so it cannot leak.
+    run_custom_job([this, binder, &sharedState, manager = sm.release(), n]() {
         // Use the binder to [maybe] bind the threads to a NUMA node before doing
         // the Worker allocation. Ideally we would also allocate the SearchManager
         // here, but that's minor.
         this->numaAccessToken = binder();
         this->worker          = make_unique_large_page<Search::Worker>(
-          sharedState, std::move(sm), n, idxInNuma, totalNuma, this->numaAccessToken);
+          sharedState, std::unique_ptr<Search::ISearchManager>(manager), n, idxInNuma, totalNuma,
+          this->numaAccessToken);
     });
-
-    wait_for_search_finished();
 }
 
 
@@ -91,10 +96,14 @@ void Thread::start_searching() {
 
 // Clears the histories for the thread worker (usually before a new game)
 void Thread::clear_worker() {
-    assert(worker != nullptr);
     run_custom_job([this]() { worker->clear(); });
 }
 
+// Clears the part of the shared histories of the node the worker is responsible for
+void Thread::clear_shared_histories() {
+    run_custom_job([this]() { worker->clear_shared_histories(); });
+}
+
 // Blocks on the condition variable until the thread has finished searching
 void Thread::wait_for_search_finished() {
 
@@ -102,6 +111,12 @@ void Thread::wait_for_search_finished() {
     cv.wait(lk, [&] { return !searching; });
 }
 
+bool Thread::is_searching() {
+
+    std::lock_guard<std::mutex> lk(mutex);
+    return searching;
+}
+
 // Launching a function in the thread
 void Thread::run_custom_job(std::function<void()> f) {
     {
@@ -144,14 +159,66 @@ Search::SearchManager* ThreadPool::main_manager() { return main_thread()->worker
 u64 ThreadPool::nodes_searched() const { return accumulate(&Search::Worker::nodes); }
 u64 ThreadPool::tb_hits() const { return accumulate(&Search::Worker::tbHits); }
 
+TTStats ThreadPool::tt_stats() const {
+
+    TTStats stats;
+    for (auto&& th : threads)
+        stats += th->worker->ttStats;
+    return stats;
+}
+
+Eval::NNUE::EvalCache::Stats ThreadPool::eval_cache_stats() const {
+
+    Eval::NNUE::EvalCache::Stats stats;
+    for (auto&& th : threads)
+        stats += th->worker->evalCache.stats;
+    return stats;
+}
+
 static usize next_power_of_two(u64 count) { return count > 1 ? (2ULL << msb(count - 1)) : 1; }
 
 // Creates/destroys threads to match the requested number.
 // Created and launched threads will immediately go to sleep in idle_loop.
-// Upon resizing, threads are recreated to allow for binding if necessary.
-void ThreadPool::set(const NumaConfig&                           numaConfig,
+// Upon resizing, threads are recreated to allow for binding if necessary, unless
+// only their number changes, see resize(). Returns true if the threads were recreated.
+bool ThreadPool::set(const NumaConfig&                           numaConfig,
                      Search::SharedState                         sharedState,
-                     const Search::SearchManager::UpdateContext& updateContext) {
+                     const Search::SearchManager::UpdateContext& updateContext,
+                     std::optional<NumaIndex>                    bindToNode) {
+
+    const TimePoint start     = now();
+    const usize     requested = sharedState.options["Threads"];
+
+    // Binding threads may be problematic when there's multiple NUMA nodes and
+    // multiple Stockfish instances running. In particular, if each instance
+    // runs a single thread then they would all be mapped to the first NUMA node.
+    // This is undesirable, and so the default behaviour (i.e. when the user does not
+    // change the NumaConfig UCI setting) is to not bind the threads to processors
+    // unless we know for sure that we span NUMA nodes and replication is required.
+    const std::string numaPolicy(sharedState.options["NumaPolicy"]);
+    const bool        doBindThreads = [&]() {
+        if (bindToNode)
+            return true;
+
+        if (numaPolicy == "none" || requested == 0)
+            return false;
+
+        if (numaPolicy == "auto")
+            return numaConfig.suggests_binding_threads(requested);
+
+        // numaPolicy == "system", or explicitly set by the user
+        return true;
+    }();
+
+    const std::string layout = numaConfig.to_string();
+
+    if (requested > 0 && threads.size() > 0 && !bindToNode && !boundToSingleNode
+        && doBindThreads == threadsBound && layout == numaLayout)
+    {
+        resize(numaConfig, sharedState, updateContext, requested);
+        setupTime = now() - start;
+        return false;
+    }
 
     if (threads.size() > 0)  // destroy any existing thread(s)
     {
@@ -162,32 +229,19 @@ void ThreadPool::set(const NumaConfig&                           numaConfig,
         boundThreadToNumaNode.clear();
     }
 
-    const usize requested = sharedState.options["Threads"];
+    threadsBound      = doBindThreads;
+    boundToSingleNode = bindToNode.has_value();
+    numaLayout        = layout;
 
     if (requested > 0)  // create new thread(s)
     {
-        // Binding threads may be problematic when there's multiple NUMA nodes and
-        // multiple Stockfish instances running. In particular, if each instance
-        // runs a single thread then they would all be mapped to the first NUMA node.
-        // This is undesirable, and so the default behaviour (i.e. when the user does not
-        // change the NumaConfig UCI setting) is to not bind the threads to processors
-        // unless we know for sure that we span NUMA nodes and replication is required.
-        const std::string numaPolicy(sharedState.options["NumaPolicy"]);
-        const bool        doBindThreads = [&]() {
-            if (numaPolicy == "none")
-                return false;
-
-            if (numaPolicy == "auto")
-                return numaConfig.suggests_binding_threads(requested);
-
-            // numaPolicy == "system", or explicitly set by the user
-            return true;
-        }();
-
         std::map<NumaIndex, usize> counts;
-        boundThreadToNumaNode = doBindThreads
-                                ? numaConfig.distribute_threads_among_numa_nodes(requested)
-                                : std::vector<NumaIndex>{};
+        if (bindToNode)
+            boundThreadToNumaNode = std::vector<NumaIndex>(requested, *bindToNode);
+        else
+            boundThreadToNumaNode = doBindThreads
+                                    ? numaConfig.distribute_threads_among_numa_nodes(requested)
+                                    : std::vector<NumaIndex>{};
 
         if (boundThreadToNumaNode.empty())
             counts[0] = requested;  // Pretend all threads are part of numa node 0
@@ -216,37 +270,133 @@ void ThreadPool::set(const NumaConfig&                           numaConfig,
 
         while (threads.size() < requested)
         {
-            const usize     threadId      = threads.size();
-            const NumaIndex numaId        = doBindThreads ? boundThreadToNumaNode[threadId] : 0;
-            auto            create_thread = [&]() {
-                auto manager = threadId == 0
-                                          ? std::unique_ptr<Search::ISearchManager>(
-                                   std::make_unique<Search::SearchManager>(updateContext))
-                                          : std::make_unique<Search::NullSearchManager>();
-
-                // When not binding threads we want to force all access to happen
-                // from the same NUMA node, because in case of NUMA replicated memory
-                // accesses we don't want to trash cache in case the threads get scheduled
-                // on the same NUMA node.
-                auto binder = doBindThreads ? OptionalThreadToNumaNodeBinder(numaConfig, numaId)
-                                                       : OptionalThreadToNumaNodeBinder(numaId);
-
-                threads.emplace_back(std::make_unique<Thread>(sharedState, std::move(manager),
-                                                                         threadId, counts[numaId]++,
-                                                                         threadsPerNode[numaId], binder));
-            };
-
-            // Ensure the worker thread inherits the intended NUMA affinity at creation.
-            if (doBindThreads)
-                numaConfig.execute_on_numa_node(numaId, create_thread);
-            else
-                create_thread();
+            const NumaIndex numaId = doBindThreads ? boundThreadToNumaNode[threads.size()] : 0;
+            add_thread(numaConfig, sharedState, updateContext, counts[numaId]++,
+                       threadsPerNode[numaId]);
         }
 
-        clear();
+        // New workers have cleared their own histories, the shared ones are cleared
+        // by all the threads of their node once they are constructed.
+        for (auto&& th : threads)
+            th->clear_shared_histories();
 
-        main_thread()->wait_for_search_finished();
+        for (auto&& th : threads)
+            th->wait_for_search_finished();
+
+        reset_main_manager();
     }
+
+    setupTime = now() - start;
+    return true;
+}
+
+// Creates the next thread, bound to its node if threads are bound
+void ThreadPool::add_thread(const NumaConfig&                           numaConfig,
+                            Search::SharedState&                        sharedState,
+                            const Search::SearchManager::UpdateContext& updateContext,
+                            usize                                       idxInNuma,
+                            usize                                       totalNuma) {
+
+    const usize     threadId      = threads.size();
+    const NumaIndex numaId        = threadsBound ? boundThreadToNumaNode[threadId] : 0;
+    auto            create_thread = [&]() {
+        auto manager = threadId == 0
+                       ? std::unique_ptr<Search::ISearchManager>(
+                           std::make_unique<Search::SearchManager>(updateContext))
+                       : std::make_unique<Search::NullSearchManager>();
+
+        // When not binding threads we want to force all access to happen
+        // from the same NUMA node, because in case of NUMA replicated memory
+        // accesses we don't want to trash cache in case the threads get scheduled
+        // on the same NUMA node.
+        auto binder = threadsBound ? OptionalThreadToNumaNodeBinder(numaConfig, numaId)
+                                   : OptionalThreadToNumaNodeBinder(numaId);
+
+        threads.emplace_back(std::make_unique<Thread>(sharedState, std::move(manager), threadId,
+                                                      idxInNuma, totalNuma, binder));
+    };
+
+    // Ensure the worker thread inherits the intended NUMA affinity at creation.
+    if (threadsBound)
+        numaConfig.execute_on_numa_node(numaId, create_thread);
+    else
+        create_thread();
+}
+
+// Adds or removes threads at the end of the pool, keeping the others with their
+// histories. Threads are distributed over the nodes one at a time, so the threads
+// that are kept stay on their nodes, and the new ones go where they keep the nodes
+// balanced. The histories shared on a node are only reallocated, and cleared, when
+// their size changes with the number of threads of the node.
+void ThreadPool::resize(const NumaConfig&                           numaConfig,
+                        Search::SharedState&                        sharedState,
+                        const Search::SearchManager::UpdateContext& updateContext,
+                        usize                                       requested) {
+
+    for (auto&& th : threads)
+        th->wait_for_search_finished();
+
+    const usize kept = std::min(requested, threads.size());
+
+    std::vector<NumaIndex> binding =
+      threadsBound ? numaConfig.distribute_threads_among_numa_nodes(requested)
+                   : std::vector<NumaIndex>{};
+
+    assert(!threadsBound
+           || std::equal(binding.begin(), binding.begin() + kept, boundThreadToNumaNode.begin()));
+
+    threads.erase(threads.begin() + kept, threads.end());
+    boundThreadToNumaNode = std::move(binding);
+
+    auto node_of = [&](usize i) { return threadsBound ? boundThreadToNumaNode[i] : NumaIndex(0); };
+
+    std::map<NumaIndex, usize> counts;
+    for (usize i = 0; i < requested; ++i)
+        counts[node_of(i)]++;
+
+    // Only nodes that lost all their threads can be left without histories
+    for (auto it = sharedState.sharedHistories.begin(); it != sharedState.sharedHistories.end();)
+        if (!counts.count(it->first))
+            it = sharedState.sharedHistories.erase(it);
+        else
+            ++it;
+
+    std::set<NumaIndex> cleared;
+    for (const auto& [numaIndex, count] : counts)
+    {
+        auto f = [&, numaIndex = numaIndex, count = count]() {
+            auto [it, inserted] =
+              sharedState.sharedHistories.try_emplace(numaIndex, next_power_of_two(count));
+
+            if (inserted || it->second.resize(next_power_of_two(count)))
+                cleared.insert(numaIndex);
+        };
+
+        if (threadsBound)
+            numaConfig.execute_on_numa_node(numaIndex, f);
+        else
+            f();
+    }
+
+    for (usize i = 0; i < kept; ++i)
+        threads[i]->worker->set_numa_thread_count(counts[node_of(i)]);
+
+    std::map<NumaIndex, usize> idxInNuma;
+    for (usize i = 0; i < kept; ++i)
+        idxInNuma[node_of(i)]++;
+
+    while (threads.size() < requested)
+    {
+        const NumaIndex numaId = node_of(threads.size());
+        add_thread(numaConfig, sharedState, updateContext, idxInNuma[numaId]++, counts[numaId]);
+    }
+
+    for (usize i = 0; i < threads.size(); ++i)
+        if (cleared.count(node_of(i)))
+            threads[i]->clear_shared_histories();
+
+    for (auto&& th : threads)
+        th->wait_for_search_finished();
 }
 
 
@@ -255,12 +405,21 @@ void ThreadPool::clear() {
     if (threads.size() == 0)
         return;
 
+    const TimePoint start = now();
+
     for (auto&& th : threads)
         th->clear_worker();
 
     for (auto&& th : threads)
         th->wait_for_search_finished();
 
+    clearTime = now() - start;
+
+    reset_main_manager();
+}
+
+// Resets the state the main thread keeps between searches of a game
+void ThreadPool::reset_main_manager() {
     // These two affect the time taken on the first move of a game:
     main_manager()->bestPreviousAverageScore = VALUE_INFINITE;
     main_manager()->previousTimeReduction    = 0.85;
@@ -284,6 +443,14 @@ void ThreadPool::wait_on_thread(usize threadId) {
 usize ThreadPool::num_threads() const { return threads.size(); }
 
 
+// Only states taken back are kept. While the threads still have their own, the states
+// given here were set up after the last start_thinking(), and no search uses them.
+void ThreadPool::keep_setup_states(StateListPtr states) {
+    if (!setupStates)
+        setupStates = std::move(states);
+}
+
+
 // Wakes up main thread waiting in idle_loop() and returns immediately.
 // Main thread will wake up other threads and start the search.
 void ThreadPool::start_thinking(const OptionsMap&  options,
@@ -332,6 +499,9 @@ void ThreadPool::start_thinking(const OptionsMap&  options,
         th->run_custom_job([&]() {
             th->worker->limits = limits;
             th->worker->nodes = th->worker->tbHits = th->worker->bestMoveChanges = 0;
+            th->worker->ttStats                                                  = {};
+            th->worker->evalCache.stats                                          = {};
+            th->worker->evalCache.resize(usize(options["EvalCache"]));
             th->worker->nmpMinPly                                                = 0;
             th->worker->rootDepth                                                = 0;
             th->worker->rootMoves                                                = rootMoves;
@@ -428,6 +598,12 @@ void ThreadPool::wait_for_search_finished() const {
             th->wait_for_search_finished();
 }
 
+bool ThreadPool::searching() const {
+
+    return std::any_of(threads.begin(), threads.end(),
+                       [](const auto& th) { return th->is_searching(); });
+}
+
 std::vector<usize> ThreadPool::get_bound_thread_to_numa_node() const {
     return boundThreadToNumaNode;
 }
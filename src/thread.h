@@ -24,6 +24,8 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "memory.h"
@@ -83,6 +85,7 @@ class Thread {
     void idle_loop();
     void start_searching();
     void clear_worker();
+    void clear_shared_histories();
     void run_custom_job(std::function<void()> f);
 
     void ensure_network_replicated();
@@ -93,6 +96,7 @@ class Thread {
     // appropriate specificity regarding search, from the point of view of an
     // outside user, so renaming of this function is left for whenever that happens.
     void  wait_for_search_finished();
+    bool  is_searching();
     usize id() const { return idx; }
 
     LargePagePtr<Search::Worker> worker;
@@ -132,21 +136,36 @@ class ThreadPool {
     ThreadPool& operator=(ThreadPool&&)      = delete;
 
     void  start_thinking(const OptionsMap&, Position&, StateListPtr&, Search::LimitsType);
+    // Gives back the states handed over by start_thinking(), to extend them with more
+    // moves. Earlier states are not moved by that, so a running search is not affected.
+    // As the search may still use them, states taken back are kept here again when they
+    // are dropped, until the next search starts.
+    StateListPtr take_setup_states() { return std::move(setupStates); }
+    void         keep_setup_states(StateListPtr states);
     void  run_on_thread(usize threadId, std::function<void()> f);
     void  wait_on_thread(usize threadId);
     usize num_threads() const;
     void  clear();
-    void  set(const NumaConfig& numaConfig,
+    // How long the last set() and clear() took, in ms
+    TimePoint setup_time() const { return setupTime; }
+    TimePoint clear_time() const { return clearTime; }
+    // With bindToNode, all threads are bound to that NUMA node, whatever the NumaPolicy
+    bool  set(const NumaConfig& numaConfig,
               Search::SharedState,
-              const Search::SearchManager::UpdateContext&);
-
-    Search::SearchManager* main_manager();
-    Thread*                main_thread() const { return threads.front().get(); }
-    u64                    nodes_searched() const;
-    u64                    tb_hits() const;
-    Thread*                get_best_thread() const;
-    void                   start_searching();
-    void                   wait_for_search_finished() const;
+              const Search::SearchManager::UpdateContext&,
+              std::optional<NumaIndex> bindToNode = std::nullopt);
+
+    Search::SearchManager*       main_manager();
+    Thread*                      main_thread() const { return threads.front().get(); }
+    u64                          nodes_searched() const;
+    u64                          tb_hits() const;
+    TTStats                      tt_stats() const;
+    Eval::NNUE::EvalCache::Stats eval_cache_stats() const;
+    Thread*                      get_best_thread() const;
+    void                         start_searching();
+    void                         wait_for_search_finished() const;
+    // Whether any thread is busy with a search or a job, at the moment of the call
+    bool searching() const;
 
     std::vector<usize> get_bound_thread_to_numa_node() const;
     std::vector<usize> get_bound_thread_count_by_numa_node() const;
@@ -164,10 +183,28 @@ class ThreadPool {
     auto empty() const noexcept { return threads.empty(); }
 
    private:
+    void add_thread(const NumaConfig&,
+                    Search::SharedState&,
+                    const Search::SearchManager::UpdateContext&,
+                    usize idxInNuma,
+                    usize totalNuma);
+    void resize(const NumaConfig&,
+                Search::SharedState&,
+                const Search::SearchManager::UpdateContext&,
+                usize requested);
+    void reset_main_manager();
+
     StateListPtr                         setupStates;
     std::vector<std::unique_ptr<Thread>> threads;
     std::vector<NumaIndex>               boundThreadToNumaNode;
 
+    // How the threads were set up, a resize() keeps all of it
+    bool        threadsBound      = false;
+    bool        boundToSingleNode = false;
+    std::string numaLayout;
+
+    TimePoint setupTime = 0, clearTime = 0;
+
     u64 accumulate(RelaxedAtomic<u64> Search::Worker::* member) const {
 
         u64 sum = 0;
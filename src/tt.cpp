@@ -19,11 +19,17 @@
 #include "tt.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <new>
 #include <numeric>
+#include <ostream>
+#include <string>
 #include <vector>
 
 #include "memory.h"
@@ -52,9 +58,19 @@ namespace Stockfish {
 // externally, so we offset the internal depth by DEPTH_NONE.
 //
 // Pv, bound and generation are packed in a single byte.
+//
+// Builds with USE_COMPACT_TT (make compacttt=yes) use 8 bytes entries instead, so that four of
+// them fit in a cluster. There is no separate evaluation field: the value field holds the static
+// evaluation until a search value is stored, which is flagged by the bit freed by using a 4 bit
+// generation. Entries holding a value thus read back without evaluation, which is recomputed.
+#ifdef USE_COMPACT_TT
+static constexpr u8 GENERATION_BITS = 4;
+#else
 static constexpr u8 GENERATION_BITS = 5;
+#endif
 static constexpr u8 GENERATION_MASK = (1 << GENERATION_BITS) - 1;
-static constexpr u8 BOUND_SHIFT     = GENERATION_BITS;
+static constexpr u8 EVAL_ONLY_MASK  = 1 << 4;  // Compact layout only
+static constexpr u8 BOUND_SHIFT     = 5;
 static constexpr u8 BOUND_MASK      = 0b11 << BOUND_SHIFT;
 static constexpr u8 PV_SHIFT        = BOUND_SHIFT + 2;
 static constexpr u8 PV_MASK         = 1 << PV_SHIFT;
@@ -63,15 +79,28 @@ struct TTEntry {
 
     // Convert internal bitfields to external types
     TTData read() const {
+#ifdef USE_COMPACT_TT
+        const bool  evalOnly = genBound8 & EVAL_ONLY_MASK;
+        const Value v        = Value(value16);
+
+        return TTData{Move(move16),
+                      evalOnly ? VALUE_NONE : v,
+                      evalOnly ? v : VALUE_NONE,
+                      Depth(DEPTH_NONE + depth8),
+                      Bound((genBound8 & BOUND_MASK) >> BOUND_SHIFT),
+                      bool(genBound8 & PV_MASK)};
+#else
         return TTData{Move(move16),
                       Value(value16),
                       Value(eval16),
                       Depth(DEPTH_NONE + depth8),
                       Bound((genBound8 & BOUND_MASK) >> BOUND_SHIFT),
                       bool(genBound8 & PV_MASK)};
+#endif
     }
 
     bool is_occupied() const { return bool(depth8); };
+    void reset();
     void save(Key k, Value v, bool pv, Bound b, Depth d, Move m, Value ev, u8 curr_generation);
     u8   relative_age(const u8 curr_generation) const;
 
@@ -84,7 +113,9 @@ struct TTEntry {
     RelaxedAtomic<u8>   genBound8;
     RelaxedAtomic<Move> move16;
     RelaxedAtomic<i16>  value16;
+#ifndef USE_COMPACT_TT
     RelaxedAtomic<i16>  eval16;
+#endif
 };
 
 // Populates the TTEntry with a new node's data, possibly
@@ -96,19 +127,35 @@ void TTEntry::save(
     if (m || u16(k) != key16)
         move16 = m;
 
+    TTStats::count(&TTStats::writes);
+
     // Overwrite less valuable entries (cheapest checks first)
     if (b == BOUND_EXACT || u16(k) != key16 || d - DEPTH_NONE + 2 * pv > depth8 - 4
         || relative_age(curr_generation))
     {
+        if constexpr (TTStats::Enabled)
+        {
+            if (u16(k) == key16)
+                TTStats::count(&TTStats::updates);
+            else if (is_occupied())
+                TTStats::count_replacement(Depth(DEPTH_NONE + depth8));
+        }
+
         assert(d > DEPTH_NONE);
         assert(d - DEPTH_NONE < 256);
         assert(curr_generation <= GENERATION_MASK);  // TT::new_search() plays nice
 
-        key16     = u16(k);
-        depth8    = u8(d - DEPTH_NONE);
+        key16  = u16(k);
+        depth8 = u8(d - DEPTH_NONE);
+#ifdef USE_COMPACT_TT
+        genBound8 = u8(curr_generation | b << BOUND_SHIFT | u8(pv) << PV_SHIFT
+                       | (v == VALUE_NONE ? EVAL_ONLY_MASK : 0));
+        value16   = i16(v == VALUE_NONE ? ev : v);
+#else
         genBound8 = u8(curr_generation | b << BOUND_SHIFT | u8(pv) << PV_SHIFT);
         value16   = i16(v);
         eval16    = i16(ev);
+#endif
     }
     // Secondary aging. Important for elementary mate finding.
     // (*Scaler) Secondary aging on entries relevant to singular extensions
@@ -118,12 +165,28 @@ void TTEntry::save(
     {
         auto v16 = value16;
         if (std::abs(v16) < VALUE_INFINITE && is_decisive(v16))
+        {
             depth8 = std::max(int(depth8) - 1,
                               0);  // guard against racy underflows, default to "unoccupied"
+            TTStats::count(&TTStats::secondaryAging);
+        }
     }
 }
 
 
+// Equivalent to zeroing the entry, but safe against racing accesses
+void TTEntry::reset() {
+    key16     = 0;
+    depth8    = 0;
+    genBound8 = 0;
+    move16    = Move::none();
+    value16   = 0;
+#ifndef USE_COMPACT_TT
+    eval16 = 0;
+#endif
+}
+
+
 u8 TTEntry::relative_age(const u8 curr_generation) const {
     // Returns this entry's age. We count generations like clocks count hours,
     // i.e. we require 0 - 1 == 31. Unsigned subtraction guarantees the required
@@ -132,6 +195,46 @@ u8 TTEntry::relative_age(const u8 curr_generation) const {
 }
 
 
+thread_local TTStats* TTStats::current     = nullptr;
+thread_local int      TTStats::currentNode = -1;
+
+TTStats& TTStats::operator+=(const TTStats& other) {
+    probes += other.probes;
+    hits += other.hits;
+    falseHits += other.falseHits;
+    writes += other.writes;
+    updates += other.updates;
+    secondaryAging += other.secondaryAging;
+    localProbes += other.localProbes;
+    remoteProbes += other.remoteProbes;
+
+    for (int i = 0; i < DepthBuckets; ++i)
+        replacements[i] += other.replacements[i];
+
+    return *this;
+}
+
+std::ostream& operator<<(std::ostream& os, const TTStats& stats) {
+    auto percent = [](u64 n, u64 total) { return total ? 100.0 * n / total : 0.0; };
+
+    os << "Probes                     : " << stats.probes
+       << "\nHits [%]                   : " << percent(stats.hits, stats.probes)
+       << "\nFalse hits [% of hits]     : " << percent(stats.falseHits, stats.hits)
+       << "\nWrites                     : " << stats.writes
+       << "\nSame key updates [%]       : " << percent(stats.updates, stats.writes)
+       << "\nReplacements by depth [%]  :";
+
+    static constexpr const char* BucketNames[] = {" <1 ", ", 1-3 ", ", 4-7 ", ", 8-15 ", ", 16+ "};
+
+    for (int i = 0; i < TTStats::DepthBuckets; ++i)
+        os << BucketNames[i] << percent(stats.replacements[i], stats.writes);
+
+    return os << "\nSecondary aging [%]        : " << percent(stats.secondaryAging, stats.writes)
+              << "\nRemote NUMA probes [%]     : "
+              << percent(stats.remoteProbes, stats.localProbes + stats.remoteProbes);
+}
+
+
 // TTWriter is but a very thin wrapper around the pointer
 TTWriter::TTWriter(TTEntry* tte) :
     entry(tte) {}
@@ -151,54 +254,369 @@ void TTWriter::penalize(int penalty) {
 // of TTEntry. Each non-empty TTEntry contains information on exactly one position. The size of a Cluster should
 // divide the size of a cache line for best performance, as the cacheline is prefetched when possible.
 
+#ifdef USE_COMPACT_TT
+static constexpr int ClusterSize = 4;
+#else
 static constexpr int ClusterSize = 3;
+#endif
 
+// The last two bytes of a cluster hold the epoch of the table it was last valid in. Clusters
+// from an older epoch are considered empty and are reset on first use, so that clearing the
+// table only needs to advance its epoch. The compact layout has no room left for the epoch:
+// its clusters are always current, and clear_lazily() falls back to clear().
 struct Cluster {
     TTEntry entry[ClusterSize];
-    char    padding[2];  // Pad to 32 bytes
+#ifdef USE_COMPACT_TT
+    static constexpr bool HasEpoch = false;
+
+    bool is_current(u16) const { return true; }
+#else
+    static constexpr bool HasEpoch = true;
+
+    RelaxedAtomic<u16> epoch;
+
+    bool is_current(u16 currEpoch) const { return epoch == currEpoch; }
+#endif
+
+    void reset([[maybe_unused]] u16 currEpoch) {
+        for (TTEntry& tte : entry)
+            tte.reset();
+#ifndef USE_COMPACT_TT
+        epoch = currEpoch;
+#endif
+    }
 };
 
+static_assert(sizeof(TTEntry) == (ClusterSize == 4 ? 8 : 10), "Unexpected TTEntry size");
 static_assert(sizeof(Cluster) == 32, "Suboptimal Cluster size");
 
 
+// With NUMA partitioning, the table is split into one contiguous partition per node, so the
+// high bits of a key, which select its cluster, also select its home node. Partitions start
+// at multiples of 2 MiB, so that no (huge) page is shared between nodes. Each node's threads
+// bind the memory of its partition to the node before they first write it.
+static constexpr usize PartitionAlignment = 2 * 1024 * 1024;
+
+static usize partition_start(usize count, usize partition, usize partitions) {
+    constexpr usize ClustersPerAlignment = PartitionAlignment / sizeof(Cluster);
+
+    return partition == partitions
+           ? count
+           : count * partition / partitions / ClustersPerAlignment * ClustersPerAlignment;
+}
+
+
+// A snapshot file is a header followed by the raw cluster array. The header is padded
+// so that the table starts at an offset which is a multiple of any common page size,
+// allowing the array to be mapped directly.
+static constexpr u64   TTFileMagic      = 0x50414E5354544653;  // "SFTTSNAP"
+static constexpr u32   TTFileVersion    = 3;
+static constexpr usize TTFileHeaderSize = 64 * 1024;
+
+struct TTFileHeader {
+    u64 magic;
+    u32 version;
+    u32 clusterBytes;
+    u64 clusterCount;
+    u8  generation;
+    u16 epoch;
+    u16 entryBytes;  // Tells the entry layouts apart, which share the cluster size
+};
+
+
+// A shared table is preceded by a header holding the generation, which the attached
+// processes advance as they search, and the epoch. Zero-filled memory is a
+// valid header.
+struct alignas(64) SharedTTHeader {
+    std::atomic<u32> generation;
+    std::atomic<u16> epoch;
+};
+
+
+void TranspositionTable::free_table() {
+    if (sharedHeader)
+    {
+        sharedRegion = SystemWideSharedRegion();
+        sharedHeader = nullptr;
+    }
+    else if (mappedBytes)
+        unmap_file(reinterpret_cast<char*>(table) - TTFileHeaderSize, mappedBytes);
+    else if (!borrowed)
+        aligned_large_pages_free(table);
+
+    table       = nullptr;
+    mappedBytes = 0;
+    fileHeader  = nullptr;
+    borrowed    = false;
+    lent        = false;
+}
+
+
 // Sets the size of the transposition table,
 // measured in megabytes. Transposition table consists
 // of clusters and each cluster consists of ClusterSize number of TTEntry.
 void TranspositionTable::resize(usize mbSize, ThreadPool& threads) {
-    aligned_large_pages_free(table);
+    stop_scrub(threads);
+    free_table();
 
-    clusterCount  = mbSize * 1024 * 1024 / sizeof(Cluster);
-    usize ttBytes = clusterCount * sizeof(Cluster);
+    clusterCount   = mbSize * 1024 * 1024 / sizeof(Cluster);
+    partitionCount = 1;
+    usize ttBytes  = clusterCount * sizeof(Cluster);
+
+    // The region name includes the size and the entry layout, so processes only ever share
+    // compatible tables, and resizing moves this process to another table without disturbing
+    // others.
+    if (!sharedName.empty())
+    {
+        sharedRegion = SystemWideSharedRegion(sharedName + "/" + std::to_string(ClusterSize),
+                                              sizeof(SharedTTHeader) + ttBytes);
+
+        if (sharedRegion.is_valid())
+        {
+            char* base   = static_cast<char*>(sharedRegion.get());
+            sharedHeader = std::launder(reinterpret_cast<SharedTTHeader*>(base));
+            table        = reinterpret_cast<Cluster*>(base + sizeof(SharedTTHeader));
+
+            clear(threads);
+            return;
+        }
+
+        std::cerr << "Failed to share transposition table, using private memory." << std::endl;
+    }
+
+    table = allocate_clusters(clusterCount, threads);
+
+    clear(threads);
+}
+
+
+// Resizes the table while keeping its content: every new cluster is filled with the
+// most valuable entries of the old clusters whose key range overlaps its own. Only the
+// low 16 bits of each key are stored, so when growing an entry cannot be placed more
+// precisely than the range of new clusters covering its old one. It is copied to all of
+// them; later probes find one copy and the others are replaced over time like any other
+// stale entry. The rehash writes every new cluster, so no separate clear is needed.
+void TranspositionTable::rehash(usize mbSize, ThreadPool& threads) {
+    if (!table || !sharedName.empty())
+    {
+        resize(mbSize, threads);
+        return;
+    }
+
+    const usize newCount = mbSize * 1024 * 1024 / sizeof(Cluster);
+    Cluster*    newTable = allocate_clusters(newCount, threads);
+
+    partitionCount = count_partitions(threads);
+
+    // Lowest key of each new cluster, up to a rounding error negligible for real table sizes
+    const u64 keyStep = ~u64(0) / newCount;
+
+    for_each_cluster_range(threads, newCount, [&](usize start, usize len) {
+        if (partitionCount > 1)
+            bind_to_numa_node(&newTable[start], len * sizeof(Cluster), current_numa_node());
+
+        for (usize j = start; j < start + len; ++j)
+        {
+            const u64   lastKey  = j + 1 == newCount ? ~u64(0) : (j + 1) * keyStep - 1;
+            const usize oldFirst = mul_hi64(j * keyStep, clusterCount);
+            const usize oldLast  = std::min(mul_hi64(lastKey, clusterCount), clusterCount - 1);
+
+            // Keep the best entries by the replacement value used in probe()
+            const TTEntry* best[ClusterSize] = {};
+            int            bestValue[ClusterSize];
+
+            for (usize i = oldFirst; i <= oldLast; ++i)
+                for (const TTEntry& tte : table[i].entry)
+                {
+                    if (!table[i].is_current(epoch16) || !tte.is_occupied())
+                        continue;
+
+                    int value = tte.depth8 - 8 * tte.relative_age(generation8);
+                    int k     = ClusterSize;
+
+                    while (k > 0 && (!best[k - 1] || bestValue[k - 1] < value))
+                    {
+                        if (k < ClusterSize)
+                        {
+                            best[k]      = best[k - 1];
+                            bestValue[k] = bestValue[k - 1];
+                        }
+                        --k;
+                    }
+
+                    if (k < ClusterSize)
+                    {
+                        best[k]      = &tte;
+                        bestValue[k] = value;
+                    }
+                }
+
+            newTable[j].reset(epoch16);
+
+            for (int k = 0; k < ClusterSize && best[k]; ++k)
+                newTable[j].entry[k] = *best[k];
+        }
+    });
+
+    free_table();
+
+    table        = newTable;
+    clusterCount = newCount;
+}
+
+
+// Partitions follow the system NUMA nodes, which the threads query for themselves. The
+// NumaConfig domains the threads are bound to may be finer, e.g. one per L3 cache by default,
+// in which case several domains share a node and thus a partition.
+usize TranspositionTable::count_partitions(ThreadPool& threads) {
+    threadNodes.clear();
+
+    // Unbound threads may migrate between nodes
+    if (!numaPartitioned || !sharedName.empty() || threads.numa_nodes() < 2)
+        return 1;
+
+    threadNodes.resize(threads.num_threads());
+
+    for (usize i = 0; i < threads.num_threads(); ++i)
+        threads.run_on_thread(i, [this, i]() { threadNodes[i] = current_numa_node(); });
+
+    for (usize i = 0; i < threads.num_threads(); ++i)
+        threads.wait_on_thread(i);
+
+    std::vector<int> nodes = threadNodes;
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+    if (nodes.size() < 2 || nodes.front() < 0)
+    {
+        threadNodes.clear();
+        return 1;
+    }
+
+    return nodes.size();
+}
+
+
+Cluster* TranspositionTable::allocate_clusters(usize count, const ThreadPool& threads) {
+    const usize ttBytes = count * sizeof(Cluster);
 
     // Request 1GB pages if we'd get at least eight per NUMA node, to avoid
     // memory oversubscription
     bool hugePageHint = ttBytes >= threads.numa_nodes() * HugePageSize * 8;
 
-    table = static_cast<Cluster*>(aligned_large_pages_alloc_with_hint(ttBytes, hugePageHint));
+    auto clusters =
+      static_cast<Cluster*>(aligned_large_pages_alloc_with_hint(ttBytes, hugePageHint));
 
-    if (!table)
+    if (!clusters)
     {
-        std::cerr << "Failed to allocate " << mbSize << "MB for transposition table." << std::endl;
+        std::cerr << "Failed to allocate " << ttBytes / (1024 * 1024)
+                  << "MB for transposition table." << std::endl;
         exit(EXIT_FAILURE);
     }
 
-    clear(threads);
+    return clusters;
 }
 
 
 // Initializes the entire transposition table to zero,
 // in a multi-threaded way.
 void TranspositionTable::clear(ThreadPool& threads) {
-    generation8             = 0;
+    // Other processes may still be searching on a shared table
+    if (sharedHeader && sharedRegion.ref_count() > 1)
+    {
+        epoch16 = sharedHeader->epoch;
+        return;
+    }
+
+    if (sharedHeader)
+        sharedHeader->generation = sharedHeader->epoch = 0;
+
+    generation8      = 0;
+    sharedGeneration = 0;
+    epoch16          = 0;
+    partitionCount   = count_partitions(threads);
+
+    for_each_cluster_range(threads, clusterCount, [this](usize start, usize len) {
+        if (partitionCount > 1)
+            bind_to_numa_node(&table[start], len * sizeof(Cluster), current_numa_node());
+
+        // Each thread will zero its part of the hash table
+        std::memset(static_cast<void*>(&table[start]), 0, len * sizeof(Cluster));
+    });
+}
+
+
+// Clears the table in constant time by advancing the epoch, which makes all clusters
+// appear empty. The threads then reset the clusters in the background until a search
+// or another operation on the table needs them, see stop_scrub().
+void TranspositionTable::clear_lazily(ThreadPool& threads) {
+    stop_scrub(threads);
+
+    // Clusters could look valid again once the epoch wraps around
+    if (!Cluster::HasEpoch || (sharedHeader && sharedRegion.ref_count() > 1)
+        || epoch16 == u16(~0))
+    {
+        clear(threads);
+        return;
+    }
+
+    generation8      = 0;
+    sharedGeneration = 0;
+    ++epoch16;
+
+    if (sharedHeader)
+    {
+        sharedHeader->generation = 0;
+        sharedHeader->epoch      = epoch16;
+    }
+
+    update_file_header();
+
+    for_each_cluster_range(
+      threads, clusterCount,
+      [this](usize start, usize len) {
+          for (usize i = start; i < start + len && !scrubAbort; ++i)
+              if (!table[i].is_current(epoch16))
+                  table[i].reset(epoch16);
+      },
+      false);
+}
+
+
+// Interrupts the background reset started by clear_lazily(), if any. Clusters
+// left behind are reset on their first probe instead.
+void TranspositionTable::stop_scrub(ThreadPool& threads) {
+    scrubAbort = true;
+
+    for (usize i = 0; i < threads.num_threads(); ++i)
+        threads.wait_on_thread(i);
+
+    scrubAbort = false;
+}
+
+
+// Splits `count` clusters into one contiguous range per thread and runs `f` on each
+// range on its thread, by default waiting for all of them to finish.
+void TranspositionTable::for_each_cluster_range(ThreadPool&                       threads,
+                                                usize                             count,
+                                                std::function<void(usize, usize)> f,
+                                                bool                              wait) {
+    stop_scrub(threads);
+
     const usize threadCount = threads.num_threads();
 
     std::vector<usize> threadToNuma = threads.get_bound_thread_to_numa_node();
 
+    // With NUMA partitions, the threads are grouped by system node instead, see count_partitions()
+    const bool partitioned = partitionCount > 1 && threadNodes.size() == threadCount;
+    if (partitioned)
+        threadToNuma.assign(threadNodes.begin(), threadNodes.end());
+
     std::vector<usize> order(threadCount);
     std::iota(order.begin(), order.end(), 0);
 
     // To promote good NUMA distribution (esp. with huge pages), we permute threads so that
-    // all threads in a NUMA node clear a contiguous region of the TT.
+    // all threads in a NUMA node touch a contiguous region of the TT.
     if (threadToNuma.size() == threadCount)
     {
         std::stable_sort(order.begin(), order.end(), [&threadToNuma](usize t1, usize t2) {
@@ -206,23 +624,184 @@ void TranspositionTable::clear(ThreadPool& threads) {
         });
     }
 
+    // First cluster of each thread, in the above order
+    std::vector<usize> starts(threadCount + 1);
     for (usize i = 0; i < threadCount; ++i)
+        starts[i] = count / threadCount * i;
+    starts[threadCount] = count;
+
+    // With NUMA partitions, the threads of each node split the partition of their node
+    if (partitioned)
     {
-        threads.run_on_thread(order[i], [this, i, threadCount]() {
-            // Each thread will zero its part of the hash table
-            const usize stride = clusterCount / threadCount;
-            const usize start  = stride * i;
-            const usize len    = i + 1 != threadCount ? stride : clusterCount - start;
+        for (usize first = 0, partition = 0; first < threadCount; ++partition)
+        {
+            usize last = first;
+            while (last < threadCount && threadToNuma[order[last]] == threadToNuma[order[first]])
+                ++last;
 
-            std::memset(static_cast<void*>(&table[start]), 0, len * sizeof(Cluster));
-        });
+            const usize begin = partition_start(count, partition, partitionCount);
+            const usize end   = partition_start(count, partition + 1, partitionCount);
+
+            for (usize i = first; i < last; ++i)
+                starts[i] = begin + (end - begin) / (last - first) * (i - first);
+
+            first = last;
+        }
     }
 
     for (usize i = 0; i < threadCount; ++i)
-        threads.wait_on_thread(i);
+    {
+        threads.run_on_thread(order[i], [f, start = starts[i], end = starts[i + 1]]() {
+            f(start, end - start);
+        });
+    }
+
+    if (wait)
+        for (usize i = 0; i < threadCount; ++i)
+            threads.wait_on_thread(i);
+}
+
+
+// Writes the table to a new file and moves it into place, so that a table
+// mapped from the same path is never overwritten while in use.
+bool TranspositionTable::save(const std::string& path) const {
+    const std::string tmpPath = path + ".tmp";
+
+    TTFileHeader header{TTFileMagic,       TTFileVersion, u32(sizeof(Cluster)),
+                        u64(clusterCount), generation8,   epoch16,
+                        u16(sizeof(TTEntry))};
+
+    std::vector<char> headerBytes(TTFileHeaderSize, 0);
+    std::memcpy(headerBytes.data(), &header, sizeof(header));
+
+    std::ofstream stream(tmpPath, std::ios::binary);
+    stream.write(headerBytes.data(), std::streamsize(headerBytes.size()));
+    stream.write(reinterpret_cast<const char*>(table),
+                 std::streamsize(clusterCount * sizeof(Cluster)));
+    stream.close();
+
+    if (!stream)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+
+// Entries of a shared file mapping are written back to the file, so its header,
+// which is part of the mapping, follows the generation and epoch for the next load().
+void TranspositionTable::update_file_header() const {
+    if (!fileHeader)
+        return;
+
+    fileHeader->generation = generation8;
+    fileHeader->epoch      = epoch16;
+}
+
+
+bool TranspositionTable::load(const std::string& path, bool shared) {
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+        return false;
+
+    const usize  fileBytes = usize(stream.tellg());
+    TTFileHeader header{};
+
+    stream.seekg(0);
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    // hashfull() samples the first 1000 clusters
+    if (!stream || header.magic != TTFileMagic || header.version != TTFileVersion
+        || header.clusterBytes != sizeof(Cluster) || header.entryBytes != sizeof(TTEntry)
+        || header.clusterCount < 1000
+        || header.generation > GENERATION_MASK
+        || fileBytes != TTFileHeaderSize + header.clusterCount * sizeof(Cluster))
+        return false;
+
+    const usize ttBytes = usize(header.clusterCount) * sizeof(Cluster);
+
+    // The header is mapped along with the table, so that a shared mapping can update it
+    auto  base     = static_cast<char*>(map_file(path, 0, TTFileHeaderSize + ttBytes, !shared));
+    auto  newTable = base ? reinterpret_cast<Cluster*>(base + TTFileHeaderSize) : nullptr;
+    usize newMappedBytes = base ? TTFileHeaderSize + ttBytes : 0;
+
+    // Without mapping support, read a private copy of the table
+    if (!newTable)
+    {
+        newTable = static_cast<Cluster*>(aligned_large_pages_alloc(ttBytes));
+
+        stream.seekg(TTFileHeaderSize);
+        if (!newTable
+            || !stream.read(reinterpret_cast<char*>(newTable), std::streamsize(ttBytes)))
+        {
+            aligned_large_pages_free(newTable);
+            return false;
+        }
+    }
+
+    free_table();
+
+    table        = newTable;
+    mappedBytes  = newMappedBytes;
+    clusterCount   = usize(header.clusterCount);
+    generation8    = header.generation;
+    epoch16        = header.epoch;
+    partitionCount = 1;  // Placed by the mapping
+
+    if (newMappedBytes && shared)
+        fileHeader = std::launder(reinterpret_cast<TTFileHeader*>(base));
+
+    return true;
+}
+
+
+usize TranspositionTable::lendable_bytes() const {
+    return table && !sharedHeader && !mappedBytes && !borrowed ? clusterCount * sizeof(Cluster)
+                                                               : 0;
+}
+
+
+void* TranspositionTable::lend(ThreadPool& threads) {
+    assert(lendable_bytes());
+
+    stop_scrub(threads);
+    lent = true;
+    return table;
+}
+
+
+void TranspositionTable::reclaim(ThreadPool& threads) {
+    if (!lent)
+        return;
+
+    lent = false;
+    clear(threads);
 }
 
 
+void TranspositionTable::attach(void* mem, usize bytes, ThreadPool& threads) {
+    stop_scrub(threads);
+    free_table();
+
+    table        = static_cast<Cluster*>(mem);
+    clusterCount = bytes / sizeof(Cluster);
+    borrowed     = true;
+
+    clear(threads);
+}
+
+
+std::string TranspositionTable::layout_info() {
+    return std::to_string(ClusterSize) + " entries of " + std::to_string(sizeof(TTEntry))
+         + " bytes per cluster" + (ClusterSize == 4 ? " (compact)" : "");
+}
+
+
+usize TranspositionTable::size_mb() const { return clusterCount * sizeof(Cluster) / (1024 * 1024); }
+
+
 // Returns an approximation of the hashtable
 // occupation during a search. The hash is x permill full, as per UCI protocol.
 // Only counts entries which are younger than maxAge.
@@ -230,7 +809,7 @@ int TranspositionTable::hashfull(int maxAge) const {
     int cnt = 0;
     for (int i = 0; i < 1000; ++i)
         for (int j = 0; j < ClusterSize; ++j)
-            cnt += table[i].entry[j].is_occupied()
+            cnt += table[i].is_current(epoch16) && table[i].entry[j].is_occupied()
                 && table[i].entry[j].relative_age(generation8) <= maxAge;
 
     return cnt / ClusterSize;
@@ -238,9 +817,28 @@ int TranspositionTable::hashfull(int maxAge) const {
 
 
 void TranspositionTable::new_search() {
-    ++generation8;
+    // A process advances the shared generation only if no other one did since its last
+    // search, so the entries age with the busiest process and not with all of them together.
+    if (sharedHeader)
+    {
+        u32 seen         = sharedGeneration;
+        sharedGeneration = sharedHeader->generation.compare_exchange_strong(
+                             seen, seen + 1, std::memory_order_relaxed)
+                           ? seen + 1
+                           : seen;
+        generation8      = u8(sharedGeneration);
+    }
+    else
+        ++generation8;
+
     // Don't overflow into the other bits of TTEntry::genBound8
     generation8 &= GENERATION_MASK;
+
+    update_file_header();
+
+    // Pages may have moved between nodes, so locate them again for every search
+    if constexpr (TTStats::Enabled)
+        pageNodes = numa_nodes_of(table, clusterCount * sizeof(Cluster), PartitionAlignment);
 }
 
 
@@ -253,14 +851,33 @@ u8 TranspositionTable::generation() const { return generation8; }
 // to be replaced later. The value of an entry is its depth minus 8 times its relative age.
 std::tuple<bool, TTData, TTWriter> TranspositionTable::probe(const Key key) const {
 
-    TTEntry* const tte   = first_entry(key);
+    const usize index   = mul_hi64(key, clusterCount);
+    Cluster&    cluster = table[index];
+
+    if constexpr (TTStats::Enabled)
+        if (!pageNodes.empty())
+            TTStats::count_locality(pageNodes[index * sizeof(Cluster) / PartitionAlignment]);
+
+    // Clusters not reset since the last clear_lazily() are empty
+    if (!cluster.is_current(epoch16))
+        cluster.reset(epoch16);
+
+    TTEntry* const tte   = &cluster.entry[0];
     const u16      key16 = u16(key);  // Use the low 16 bits as key inside the cluster
 
+    TTStats::count(&TTStats::probes);
+
     for (int i = 0; i < ClusterSize; ++i)
         if (tte[i].key16 == key16)
+        {
+            if constexpr (TTStats::Enabled)
+                if (tte[i].is_occupied())
+                    TTStats::count(&TTStats::hits);
+
             // This gap is the main place for read races.
             // After `read()` completes that copy is final, but may be self-inconsistent.
             return {tte[i].is_occupied(), tte[i].read(), TTWriter(&tte[i])};
+        }
 
     // Find an entry to be replaced according to the replacement strategy
     TTEntry* replace = tte;
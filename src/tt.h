@@ -19,10 +19,16 @@
 #ifndef TT_H_INCLUDED
 #define TT_H_INCLUDED
 
+#include <atomic>
+#include <functional>
+#include <iosfwd>
+#include <string>
 #include <tuple>
+#include <vector>
 
 #include "misc.h"
 #include "memory.h"
+#include "shm.h"
 #include "types.h"
 
 namespace Stockfish {
@@ -30,6 +36,8 @@ namespace Stockfish {
 class ThreadPool;
 struct TTEntry;
 struct Cluster;
+struct SharedTTHeader;
+struct TTFileHeader;
 
 // There is only one global hash table for the engine and all its threads. For chess in particular, we even allow racy
 // updates between threads to and from the TT, as taking the time to synchronize access would cost thinking time and
@@ -62,6 +70,51 @@ struct TTData {
 };
 
 
+// Counters of TT activity, only maintained in builds with USE_TT_STATS (make ttstats=yes).
+// Each search thread owns one on its own cache line, so counting never causes contention.
+struct alignas(64) TTStats {
+#ifdef USE_TT_STATS
+    static constexpr bool Enabled = true;
+#else
+    static constexpr bool Enabled = false;
+#endif
+
+    // Replacements are bucketed by the depth of the overwritten entry: < 1, < 4, < 8, < 16, more
+    static constexpr int DepthBuckets = 5;
+
+    u64 probes = 0, hits = 0, falseHits = 0;
+    u64 writes = 0, updates = 0, replacements[DepthBuckets] = {}, secondaryAging = 0;
+    u64 localProbes = 0, remoteProbes = 0;  // Probes of clusters with known NUMA placement
+
+    TTStats& operator+=(const TTStats& other);
+
+    static void count(u64 TTStats::* counter) {
+        if constexpr (Enabled)
+            if (current)
+                ++(current->*counter);
+    }
+
+    static void count_replacement(Depth d) {
+        if constexpr (Enabled)
+            if (current)
+                ++current->replacements[d < 1 ? 0 : d < 4 ? 1 : d < 8 ? 2 : d < 16 ? 3 : 4];
+    }
+
+    static void count_locality(int node) {
+        if constexpr (Enabled)
+            if (current && node >= 0 && currentNode >= 0)
+                ++(node == currentNode ? current->localProbes : current->remoteProbes);
+    }
+
+    // The counters and the NUMA node of the calling thread, set by each worker when it
+    // starts searching
+    static thread_local TTStats* current;
+    static thread_local int      currentNode;
+};
+
+std::ostream& operator<<(std::ostream& os, const TTStats& stats);
+
+
 // This is used to make racy, non-atomic writes to the global TT. Writes are not "guaranteed":
 // for chess reasons, we may decide the new data is less important than the old.
 struct TTWriter {
@@ -79,10 +132,45 @@ struct TTWriter {
 class TranspositionTable {
 
    public:
-    ~TranspositionTable() { aligned_large_pages_free(table); }
+    ~TranspositionTable() { free_table(); }
 
     void resize(usize mbSize, ThreadPool& threads);  // Set TT size in MiB
     void clear(ThreadPool& threads);                 // Re-initialize memory, multithreaded
+    void rehash(usize mbSize, ThreadPool& threads);  // Resize keeping entries, multithreaded
+    void clear_lazily(ThreadPool& threads);          // Constant time clear, see tt.cpp
+    void stop_scrub(ThreadPool& threads);            // Wait for background work on the table
+
+    // With a non-empty name, the next resize() places the table in shared memory, so that all
+    // processes using the same name and size probe and write the same table.
+    void set_shared_name(const std::string& name) { sharedName = name; }
+    bool is_shared() const { return sharedHeader != nullptr; }
+    u32  shared_ref_count() const { return sharedRegion.ref_count(); }
+
+    // When enabled and the threads are bound to several NUMA nodes, the next resize() gives
+    // each node a contiguous partition of the table, bound to the node's memory, see tt.cpp.
+    void set_numa_partitioned(bool enabled) { numaPartitioned = enabled; }
+    bool  is_numa_partitioned() const { return partitionCount > 1; }
+    usize partition_count() const { return partitionCount; }
+
+    // Snapshots of the table. `load` maps the file into memory where supported, copy-on-write
+    // unless `shared` is set, in which case writes and the generation go back to the file. It
+    // keeps the table unchanged on failure. The stored generation is restored, so entry ages
+    // remain meaningful.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path, bool shared);
+    usize size_mb() const;
+
+    // While no search runs, the memory of an owned table can be lent out, to the tables of
+    // other searches or to the perft hash. Shared and mapped tables are in use elsewhere too,
+    // so they lend nothing. The borrowers leave arbitrary data behind, so reclaim() clears
+    // the table. A table attached to lent memory does not own it.
+    usize lendable_bytes() const;
+    void* lend(ThreadPool& threads);
+    void  reclaim(ThreadPool& threads);
+    void  attach(void* mem, usize bytes, ThreadPool& threads);
+
+    // Describes the entry layout selected at compile time, see tt.cpp
+    static std::string layout_info();
 
     void
     new_search();  // This must be called at the beginning of each root search to track entry aging
@@ -101,10 +189,35 @@ class TranspositionTable {
    private:
     friend struct TTEntry;
 
-    usize    clusterCount;
-    Cluster* table = nullptr;
-
-    u8 generation8 = 0;
+    void            free_table();
+    void            update_file_header() const;
+    usize           count_partitions(ThreadPool& threads);
+    static Cluster* allocate_clusters(usize count, const ThreadPool& threads);
+    void            for_each_cluster_range(ThreadPool&                       threads,
+                                           usize                             count,
+                                           std::function<void(usize, usize)> f,
+                                           bool                              wait = true);
+
+    usize         clusterCount;
+    Cluster*      table       = nullptr;
+    usize         mappedBytes = 0;        // Non-zero if the table is a file mapping
+    TTFileHeader* fileHeader  = nullptr;  // Non-null if the mapping writes back to the file
+    bool          borrowed    = false;    // The memory belongs to another table
+    bool          lent        = false;    // The memory is used by others until reclaim()
+
+    std::string            sharedName;
+    SystemWideSharedRegion sharedRegion;
+    SharedTTHeader*        sharedHeader = nullptr;  // Non-null if the table is shared
+
+    bool             numaPartitioned = false;
+    usize            partitionCount  = 1;
+    std::vector<int> threadNodes;  // System NUMA node of each thread, with partitions
+    std::vector<int> pageNodes;    // NUMA node of each 2 MiB of the table, in ttstats builds
+
+    u8                generation8      = 0;
+    u32               sharedGeneration = 0;  // Of the header, at this process's last search
+    u16               epoch16          = 0;
+    std::atomic<bool> scrubAbort{false};
 };
 
 }  // namespace Stockfish
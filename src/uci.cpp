@@ -19,9 +19,11 @@
 #include "uci.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cmath>
 #include <cstdlib>
+#include <iomanip>
 #include <iterator>
 #include <optional>
 #include <sstream>
@@ -30,12 +32,15 @@
 #include <vector>
 
 #include "benchmark.h"
+#include "datagen.h"
 #include "engine.h"
 #include "memory.h"
 #include "movegen.h"
 #include "position.h"
 #include "score.h"
+#include "numa.h"
 #include "search.h"
+#include "server.h"
 #include "types.h"
 #include "ucioption.h"
 
@@ -65,7 +70,12 @@ void UCIEngine::print_info_string(std::string_view str) {
 
 UCIEngine::UCIEngine(int argc, char** argv) :
     engine(argv[0]),
-    cli(argc, argv) {
+    cli(argc, argv),
+    output(engine.get_options(), [](std::string_view data) {
+        sync_cout_start();
+        std::cout.write(data.data(), std::streamsize(data.size())) << std::flush;
+        sync_cout_end();
+    }) {
 
     engine.get_options().add_info_listener([](const std::optional<std::string>& str) {
         if (str.has_value())
@@ -76,11 +86,11 @@ UCIEngine::UCIEngine(int argc, char** argv) :
 }
 
 void UCIEngine::init_search_update_listeners() {
-    engine.set_on_iter([](const auto& i) { on_iter(i); });
-    engine.set_on_update_no_moves([](const auto& i) { on_update_no_moves(i); });
-    engine.set_on_update_full(
-      [this](const auto& i) { on_update_full(i, engine.get_options()["UCI_ShowWDL"]); });
-    engine.set_on_bestmove([](const auto& bm, const auto& p) { on_bestmove(bm, p); });
+    engine.set_on_iter([this](const auto& i) { output.on_iter(i); });
+    engine.set_on_update_no_moves([this](const auto& i) { output.on_update_no_moves(i); });
+    engine.set_on_update_full([this](const auto& i) { output.on_update_full(i); });
+    engine.set_on_bestmove([this](const auto& bm, const auto& p) { output.on_bestmove(bm, p); });
+    engine.set_on_tick([this]() { output.on_tick(); });
     engine.set_on_verify_network([](const auto& s) { print_info_string(s); });
 }
 
@@ -143,20 +153,65 @@ void UCIEngine::loop() {
             bench(is);
         else if (token == BenchmarkCommand)
             benchmark(is);
+        else if (token == "historybench")
+            history_bench(is);
+        else if (token == "analyse")
+            analyse(is);
+        else if (token == "gensfen")
+            gensfen(is);
+        else if (token == "server")
+            serve(is);
+        else if (token == "perftsuite")
+        {
+            std::string file;
+
+            if (is >> file)
+                engine.perft_suite(file);
+            else
+                sync_cout << "Usage: perftsuite <file>" << sync_endl;
+        }
         else if (token == "d")
             sync_cout << engine.visualize() << sync_endl;
         else if (token == "eval")
             engine.trace_eval();
         else if (token == "compiler")
-            sync_cout << compiler_info() << sync_endl;
+            sync_cout << compiler_info() << engine.thread_timing_information_as_string()
+                      << sync_endl;
+        else if (token == "ttstats")
+        {
+            if constexpr (TTStats::Enabled)
+                sync_cout << engine.get_tt_stats() << sync_endl;
+            else
+                sync_cout << "TT statistics are only available in builds with ttstats=yes"
+                          << sync_endl;
+        }
         else if (token == "export_net")
         {
             std::pair<std::optional<std::string>, std::string> file;
+            std::string                                        format;
 
             if (is >> file.second)
                 file.first = file.second;
 
-            engine.save_network(file);
+            // 'export_net <file> mapped' saves the network ready to be mapped, for this build
+            if (is >> format && format == "mapped")
+                engine.save_network(file, true);
+            else
+                engine.save_network(file);
+        }
+        else if (token == "export_hash")
+        {
+            std::string file;
+
+            if (is >> file)
+                engine.save_tt(file);
+        }
+        else if (token == "import_hash")
+        {
+            std::string file, mode;
+
+            if (is >> file)
+                engine.load_tt(file, is >> mode && mode == "shared");
         }
         else if (token == "--help" || token == "help" || token == "--license" || token == "license")
             sync_cout
@@ -223,15 +278,111 @@ void UCIEngine::go(std::istringstream& is) {
         engine.go(limits);
 }
 
+// Searches all positions of a file, one per thread, e.g. 'analyse games.epd depth 12'.
+// Results are printed as each position finishes, so they are not in file order.
+void UCIEngine::analyse(std::istream& is) {
+    std::string file;
+    is >> file;
+
+    const Search::LimitsType limits = parse_limits(is);
+
+    if (file.empty() || (!limits.depth && !limits.nodes && !limits.movetime && !limits.mate))
+    {
+        sync_cout << "Usage: analyse <file> depth|nodes|movetime|mate <n>" << sync_endl;
+        return;
+    }
+
+    std::atomic<usize> count = 0;
+    const TimePoint    start = now();
+
+    auto err = engine.analyse(file, limits, [&](const Engine::InfoAnalysis& info) {
+        sync_cout << "analysis " << info.index << " depth " << info.depth << " seldepth "
+                  << info.selDepth << " score " << format_score(info.score) << " nodes "
+                  << info.nodes << " time " << info.timeMs << " bestmove " << info.bestmove
+                  << (info.pv.empty() ? "" : " pv " + info.pv) << sync_endl;
+        ++count;
+    });
+
+    if (err)
+        print_info_string(*err);
+    else
+        print_info_string("Analysed " + std::to_string(count) + " positions in "
+                          + std::to_string(now() - start) + " ms");
+}
+
+// Generates training data with self-play games, one per thread, e.g.
+// 'gensfen data.bin positions 1000000 nodes 5000'. See datagen.h for the options.
+void UCIEngine::gensfen(std::istream& is) {
+    DataGen::Config config;
+    std::string     token;
+
+    is >> config.file;
+
+    while (is >> token)
+        if (token == "positions")
+            is >> config.positions;
+        else if (token == "nodes")
+            is >> config.nodes;
+        else if (token == "randomplies")
+            is >> config.randomPlies;
+        else if (token == "maxply")
+            is >> config.maxPly;
+        else if (token == "evallimit")
+            is >> config.evalLimit;
+
+    if (config.file.empty() || !config.positions || !config.nodes)
+    {
+        sync_cout << "Usage: gensfen <file> [positions <n>] [nodes <n>] [randomplies <n>]"
+                     " [maxply <n>] [evallimit <cp>]"
+                  << sync_endl;
+        return;
+    }
+
+    DataGen::Progress last{0, 0, 0};
+    TimePoint         lastPrint = 0;
+
+    auto err = engine.gensfen(config, [&](const DataGen::Progress& p) {
+        last = p;
+
+        if (p.elapsed - lastPrint < 10000)
+            return;
+
+        lastPrint = p.elapsed;
+        print_info_string(std::to_string(p.positions) + " positions, " + std::to_string(p.games)
+                          + " games, " + std::to_string(p.positions * 1000 / p.elapsed)
+                          + " positions/second");
+    });
+
+    if (err)
+    {
+        print_info_string(*err);
+        return;
+    }
+
+    const TimePoint elapsed = std::max(last.elapsed, TimePoint(1));
+    const u64       perCore =
+      last.positions * 1000 / elapsed / std::max(engine.search_threads(), usize(1));
+
+    sync_cout << "\n==========================="
+              << "\nPositions          : " << last.positions  //
+              << "\nGames              : " << last.games
+              << "\nTotal time (ms)    : " << elapsed  //
+              << "\nPositions/second   : " << last.positions * 1000 / elapsed
+              << "\nPositions/s/thread : " << perCore << sync_endl;
+}
+
 void UCIEngine::bench(std::istream& args) {
     std::string token;
     u64         num, nodes = 0, cnt = 1;
     u64         nodesSearched = 0;
-    const auto& options       = engine.get_options();
+
+    // With 'evalbatch' the positions are only collected, repeated limit times, and
+    // evaluated at once with the batch evaluation after the loop.
+    std::vector<std::string> batchFens;
 
     engine.set_on_update_full([&](const auto& i) {
         nodesSearched = i.nodes;
-        on_update_full(i, options["UCI_ShowWDL"]);
+        output.on_update_full(i);
     });
 
     std::vector<std::string> list = Benchmark::setup_bench(engine.fen(), args);
@@ -246,7 +397,13 @@ void UCIEngine::bench(std::istream& args) {
         std::istringstream is(cmd);
         is >> token;
 
-        if (token == "go" || token == "eval")
+        if (token == "evalbatch")
+        {
+            usize repeat = 1;
+            is >> repeat;
+            batchFens.insert(batchFens.end(), repeat, engine.fen());
+        }
+        else if (token == "go" || token == "eval")
         {
             std::cerr << "\nPosition: " << cnt++ << '/' << num << " (" << engine.fen() << ")"
                       << std::endl;
@@ -279,6 +436,28 @@ void UCIEngine::bench(std::istream& args) {
         }
     }
 
+    if (!batchFens.empty())
+    {
+        std::vector<Value> values;
+
+        engine.set_on_update_full([this](const auto& i) { output.on_update_full(i); });
+        elapsed = now();
+
+        if (auto err = engine.evaluate_batch(batchFens, values))
+        {
+            sync_cout << "info string " << *err << sync_endl;
+            return;
+        }
+
+        elapsed = now() - elapsed + 1;
+
+        std::cerr << "\n==========================="        //
+                  << "\nTotal time (ms)     : " << elapsed  //
+                  << "\nPositions evaluated : " << values.size()
+                  << "\nPositions/second    : " << 1000 * values.size() / elapsed << std::endl;
+        return;
+    }
+
     elapsed = now() - elapsed + 1;  // Ensure positivity to avoid a 'divide by zero'
 
     dbg_print();
@@ -289,7 +468,7 @@ void UCIEngine::bench(std::istream& args) {
               << "\nNodes/second    : " << 1000 * nodes / elapsed << std::endl;
 
     // reset callback, to not capture a dangling reference to nodesSearched
-    engine.set_on_update_full([&](const auto& i) { on_update_full(i, options["UCI_ShowWDL"]); });
+    engine.set_on_update_full([this](const auto& i) { output.on_update_full(i); });
 }
 
 void UCIEngine::benchmark(std::istream& args) {
@@ -299,6 +478,9 @@ void UCIEngine::benchmark(std::istream& args) {
     std::string token;
     u64         nodes = 0, cnt = 1;
     u64         nodesSearched = 0;
+    TTStats     ttStats;
+
+    Eval::NNUE::EvalCache::Stats evalCacheStats;
 
     engine.set_on_update_full([&](const Engine::InfoFull& i) { nodesSearched = i.nodes; });
 
@@ -397,6 +579,11 @@ void UCIEngine::benchmark(std::istream& args) {
 
             updateHashfullReadings();
 
+            if constexpr (TTStats::Enabled)
+                ttStats += engine.get_tt_stats();
+
+            evalCacheStats += engine.get_eval_cache_stats();
+
             nodes += nodesSearched;
         }
         else if (token == "position")
@@ -421,6 +608,13 @@ void UCIEngine::benchmark(std::istream& args) {
     if (threadBinding.empty())
         threadBinding = "none";
 
+    std::ostringstream evalCacheHits;
+    if (evalCacheStats.probes)
+        evalCacheHits << std::fixed << std::setprecision(1)
+                      << 100.0 * evalCacheStats.hits / evalCacheStats.probes;
+    else
+        evalCacheHits << "-";
+
     // clang-format off
 
     std::cerr << "==========================="
@@ -436,6 +630,9 @@ void UCIEngine::benchmark(std::istream& args) {
               << "\nThread count               : " << setup.threads
               << "\nThread binding             : " << threadBinding
               << "\nTT size [MiB]              : " << setup.ttSize
+              << "\nTT layout                  : " << TranspositionTable::layout_info()
+              << "\nEval cache [MiB/thread]    : " << int(engine.get_options()["EvalCache"])
+              << "\nEval cache hits [%]        : " << evalCacheHits.str()
               << "\nHash max, avg [per mille]  : "
               << "\n    single search          : " << maxHashfull[0] << ", "
               << totalHashfull[0] / numHashfullReadings
@@ -447,10 +644,162 @@ void UCIEngine::benchmark(std::istream& args) {
 
     // clang-format on
 
+    if constexpr (TTStats::Enabled)
+        std::cerr << "TT statistics" << "\n" << ttStats << std::endl;
+
     init_search_update_listeners();
 }
 
+// Compares how the threads share their histories: the bench positions are searched to a
+// fixed depth once for every NUMA policy given, as the threads of a NUMA node share one
+// set of histories, e.g. 'historybench 32 13 none auto l3 l3:16'. The defaults are all
+// processors, depth 13 and the policies none, auto and l3.
+void UCIEngine::history_bench(std::istream& args) {
+    struct Run {
+        std::string policy;
+        usize       histories;
+        u64         nodes;
+        TimePoint   time;
+    };
+
+    usize                    threadCount = get_hardware_concurrency();
+    int                      depth       = 13;
+    std::vector<std::string> policies;
+    std::string              token;
+
+    if (args >> token)
+        threadCount = str_to_size_t(token);
+    if (args >> token)
+        depth = std::stoi(token);
+    while (args >> token)
+        policies.push_back(token);
+
+    if (policies.empty())
+        policies = {"none", "auto", "l3"};
+
+    const std::string previousPolicy  = engine.get_options()["NumaPolicy"];
+    const std::string previousThreads = engine.get_options()["Threads"];
+    u64               nodesSearched   = 0;
+
+    engine.set_on_update_full([&](const Engine::InfoFull& i) { nodesSearched = i.nodes; });
+    engine.set_on_iter([](const auto&) {});
+    engine.set_on_update_no_moves([](const auto&) {});
+    engine.set_on_bestmove([](const auto&, const auto&) {});
+    engine.set_on_verify_network([](const auto&) {});
+
+    std::vector<Run> runs;
+
+    for (const auto& policy : policies)
+    {
+        auto ss = std::istringstream("name NumaPolicy value " + policy);
+        setoption(ss);
+
+        std::istringstream benchArgs("16 " + std::to_string(threadCount) + " "
+                                     + std::to_string(depth) + " default depth");
+
+        Run run{policy, 0, 0, 0};
+
+        for (const auto& cmd : Benchmark::setup_bench(engine.fen(), benchArgs))
+        {
+            std::istringstream is(cmd);
+            is >> token;
+
+            if (token == "go")
+            {
+                Search::LimitsType limits = parse_limits(is);
+
+                nodesSearched     = 0;
+                TimePoint elapsed = now();
+
+                engine.go(limits);
+                engine.wait_for_search_finished();
+
+                run.time += now() - elapsed;
+                run.nodes += nodesSearched;
+            }
+            else if (token == "setoption")
+                setoption(is);
+            else if (token == "position")
+                position(is);
+            else if (token == "ucinewgame")
+                engine.search_clear();
+        }
+
+        // Unbound threads all share the histories of node 0
+        for (const auto& [bound, cpus] : engine.get_bound_thread_count_by_numa_node())
+            run.histories += bound > 0;
+
+        run.histories = std::max<usize>(run.histories, 1);
+        run.time      = std::max<TimePoint>(run.time, 1);
+        runs.push_back(run);
+    }
+
+    auto ss = std::istringstream("name NumaPolicy value " + previousPolicy);
+    setoption(ss);
+    ss = std::istringstream("name Threads value " + previousThreads);
+    setoption(ss);
+
+    init_search_update_listeners();
+
+    std::ostringstream out;
+
+    out << "\n===========================" << "\nThreads : " << threadCount
+        << "\nDepth   : " << depth << "\n\n"
+        << std::left << std::setw(16) << "NumaPolicy" << std::right << std::setw(10)
+        << "Histories" << std::setw(16) << "Nodes/second" << std::setw(20) << "Time to depth [s]"
+        << std::fixed << std::setprecision(2);
+
+    for (const auto& run : runs)
+        out << "\n"
+            << std::left << std::setw(16) << run.policy << std::right << std::setw(10)
+            << run.histories << std::setw(16) << 1000 * run.nodes / run.time << std::setw(20)
+            << run.time / 1000.0;
+
+    std::cerr << out.str() << std::endl;
+}
+
+// Serves UCI sessions on a Unix domain socket until interrupted, sharing the given
+// number of cores among them, by default all, e.g. 'server /tmp/stockfish.sock 32'.
+void UCIEngine::serve(std::istream& is) {
+    std::string path;
+    usize       cores = get_hardware_concurrency();
+
+    if (!(is >> path))
+    {
+        sync_cout << "Usage: server <socket> [cores]" << sync_endl;
+        return;
+    }
+
+    if (usize n; is >> n && n > 0)
+        cores = n;
+
+    engine.wait_for_search_finished();
+
+    sync_cout << "info string Serving sessions on " << path << " with " << cores << " cores"
+              << sync_endl;
+
+    if (!Server(engine, cores).run(path))
+        sync_cout << "info string Unable to listen on " << path << sync_endl;
+}
+
 void UCIEngine::setoption(std::istringstream& is) {
+    // A network is loaded without waiting, the search switches to it by itself
+    std::string token, name, value;
+    const auto  start = is.tellg();
+    is >> token >> name >> token;
+
+    if (to_lower(name) == "evalfile" && token == "value")
+    {
+        while (is >> token)
+            value += (value.empty() ? "" : " ") + token;
+
+        if (engine.load_network_while_searching(value == "<empty>" ? "" : value))
+            return;
+    }
+
+    is.clear();
+    is.seekg(start);
+
     engine.wait_for_search_finished();
     engine.get_options().setoption(is);
 }
@@ -461,10 +810,11 @@ u64 UCIEngine::perft(const Search::LimitsType& limits) {
     return nodes;
 }
 
-void UCIEngine::position(std::istringstream& is) {
-    const std::string fullCommand = is.str();
-
-    std::string token, fen;
+// Reads the arguments of a 'position' command, returns false if there is no position
+bool UCIEngine::parse_position(std::istream&             is,
+                               std::string&              fen,
+                               std::vector<std::string>& moves) {
+    std::string token;
 
     is >> token;
 
@@ -477,15 +827,25 @@ void UCIEngine::position(std::istringstream& is) {
         while (is >> token && token != "moves")
             fen += token + " ";
     else
-        return;
-
-    std::vector<std::string> moves;
+        return false;
 
     while (is >> token)
     {
         moves.push_back(token);
     }
 
+    return true;
+}
+
+void UCIEngine::position(std::istringstream& is) {
+    const std::string fullCommand = is.str();
+
+    std::string              fen;
+    std::vector<std::string> moves;
+
+    if (!parse_position(is, fen, moves))
+        return;
+
     auto err = engine.set_position(fen, moves);
     if (err.has_value())
     {
@@ -595,6 +955,14 @@ std::string UCIEngine::move(Move m, bool chess960) {
     return move;
 }
 
+std::string UCIEngine::format_pv(const Search::PVMoves& pv, bool chess960) {
+    std::string str;
+
+    for (Move m : pv)
+        str += (str.empty() ? "" : " ") + move(m, chess960);
+
+    return str;
+}
 
 std::string UCIEngine::to_lower(std::string str) {
     std::transform(str.begin(), str.end(), str.begin(), [](auto c) { return std::tolower(c); });
@@ -612,11 +980,11 @@ Move UCIEngine::to_move(const Position& pos, std::string str) {
     return Move::none();
 }
 
-void UCIEngine::on_update_no_moves(const Engine::InfoShort& info) {
-    sync_cout << "info depth " << info.depth << " score " << format_score(info.score) << sync_endl;
+std::string UCIEngine::format_info(const Engine::InfoShort& info) {
+    return "info depth " + std::to_string(info.depth) + " score " + format_score(info.score);
 }
 
-void UCIEngine::on_update_full(const Engine::InfoFull& info, bool showWDL) {
+std::string UCIEngine::format_info(const Engine::InfoFull& info, bool showWDL) {
     std::stringstream ss;
 
     ss << "info";
@@ -636,12 +1004,12 @@ void UCIEngine::on_update_full(const Engine::InfoFull& info, bool showWDL) {
        << " hashfull " << info.hashfull  //
        << " tbhits " << info.tbHits      //
        << " time " << info.timeMs        //
-       << " pv " << info.pv;             //
+       << " pv " << format_pv(*info.pv, info.chess960);
 
-    sync_cout << ss.str() << sync_endl;
+    return ss.str();
 }
 
-void UCIEngine::on_iter(const Engine::InfoIter& info) {
+std::string UCIEngine::format_info(const Engine::InfoIter& info) {
     std::stringstream ss;
 
     ss << "info";
@@ -649,14 +1017,283 @@ void UCIEngine::on_iter(const Engine::InfoIter& info) {
        << " currmove " << info.currmove               //
        << " currmovenumber " << info.currmovenumber;  //
 
-    sync_cout << ss.str() << sync_endl;
+    return ss.str();
 }
 
-void UCIEngine::on_bestmove(std::string_view bestmove, std::string_view ponder) {
-    sync_cout << "bestmove " << bestmove;
+std::string UCIEngine::format_bestmove(std::string_view bestmove, std::string_view ponder) {
+    std::string str = "bestmove " + std::string(bestmove);
+
     if (!ponder.empty())
-        std::cout << " ponder " << ponder;
-    std::cout << sync_endl;
+        str += " ponder " + std::string(ponder);
+
+    return str;
+}
+
+namespace {
+
+// Kinds of the binary records. Each record starts with its kind (u8) and the size
+// of the rest of the record (u16), all numbers are little endian.
+enum RecordKind : u8 {
+    RECORD_INFO = 1,  // u16 depth, seldepth, multipv; score; u8 bound (0 exact, 1 lower,
+                      // 2 upper); u16 win, draw, loss (0xFFFF without UCI_ShowWDL);
+                      // u16 hashfull; u64 nodes, nps, tbhits, time; u16 count, count moves
+    RECORD_INFO_NO_MOVES = 2,  // u16 depth; score
+    RECORD_CURRMOVE      = 3,  // u16 depth, currmovenumber; string currmove
+    RECORD_BESTMOVE      = 4   // string bestmove, ponder
+};
+// A score is a u8 type (0 cp, 1 mate in moves, 2 tablebase win in plies, negative for
+// a loss) and an i32 value. Moves use the 16 bit encoding of Move, strings a u8 length.
+
+enum ScoreType : u8 {
+    SCORE_CP,
+    SCORE_MATE,
+    SCORE_TB
+};
+
+std::pair<ScoreType, int> score_variant(const Score& s) {
+    if (s.is<Score::Mate>())
+    {
+        const int plies = s.get<Score::Mate>().plies;
+        return {SCORE_MATE, (plies > 0 ? plies + 1 : plies) / 2};
+    }
+
+    if (s.is<Score::Tablebase>())
+    {
+        const auto tb = s.get<Score::Tablebase>();
+        return {SCORE_TB, tb.win ? tb.plies : -tb.plies};
+    }
+
+    return {SCORE_CP, s.get<Score::InternalUnits>().value};
+}
+
+template<typename T>
+void put(std::string& record, T value) {
+    for (usize i = 0; i < sizeof(T); ++i)
+        record += char(u64(value) >> (8 * i));
+}
+
+void put_string(std::string& record, std::string_view str) {
+    put(record, u8(str.size()));
+    record += str;
+}
+
+void put_score(std::string& record, const Score& s) {
+    const auto [type, value] = score_variant(s);
+
+    put(record, u8(type));
+    put(record, i32(value));
+}
+
+std::string make_record(RecordKind kind, const std::string& body) {
+    std::string record;
+
+    put(record, u8(kind));
+    put(record, u16(body.size()));
+
+    return record + body;
+}
+
+std::string json_score(const Score& s) {
+    constexpr const char* Names[] = {"cp", "mate", "tb"};
+    const auto [type, value]      = score_variant(s);
+
+    return std::string("{\"") + Names[type] + "\":" + std::to_string(value) + "}";
+}
+
+}  // namespace
+
+InfoOutput::Format InfoOutput::format() const {
+    return options["UCI_OutputFormat"] == "json"   ? JSON
+         : options["UCI_OutputFormat"] == "binary" ? BINARY
+                                                   : TEXT;
+}
+
+std::string InfoOutput::format_info(const Engine::InfoFull& info) const {
+    const bool showWDL = options["UCI_ShowWDL"];
+    int        wdl[3]  = {-1, -1, -1};
+
+    if (showWDL)
+    {
+        std::istringstream is{std::string(info.wdl)};
+        is >> wdl[0] >> wdl[1] >> wdl[2];
+    }
+
+    switch (format())
+    {
+    case JSON : {
+        std::stringstream ss;
+
+        ss << "{\"type\":\"info\""
+           << ",\"depth\":" << info.depth           //
+           << ",\"seldepth\":" << info.selDepth     //
+           << ",\"multipv\":" << info.multiPV       //
+           << ",\"score\":" << json_score(info.score);
+
+        if (!info.bound.empty())
+            ss << ",\"bound\":\"" << info.bound << "\"";
+
+        if (showWDL)
+            ss << ",\"wdl\":[" << wdl[0] << "," << wdl[1] << "," << wdl[2] << "]";
+
+        ss << ",\"nodes\":" << info.nodes         //
+           << ",\"nps\":" << info.nps             //
+           << ",\"hashfull\":" << info.hashfull   //
+           << ",\"tbhits\":" << info.tbHits       //
+           << ",\"time\":" << info.timeMs         //
+           << ",\"pv\":[";
+
+        for (usize i = 0; i < info.pv->size(); ++i)
+            ss << (i ? ",\"" : "\"") << UCIEngine::move((*info.pv)[i], info.chess960) << "\"";
+
+        ss << "]}\n";
+
+        return ss.str();
+    }
+    case BINARY : {
+        std::string body;
+
+        put(body, u16(info.depth));
+        put(body, u16(info.selDepth));
+        put(body, u16(info.multiPV));
+        put_score(body, info.score);
+        put(body, u8(info.bound.empty() ? 0 : info.bound[0] == 'l' ? 1 : 2));
+
+        for (int v : wdl)
+            put(body, u16(v));
+
+        put(body, u16(info.hashfull));
+        put(body, u64(info.nodes));
+        put(body, u64(info.nps));
+        put(body, u64(info.tbHits));
+        put(body, u64(info.timeMs));
+        put(body, u16(info.pv->size()));
+
+        for (Move m : *info.pv)
+            put(body, m.raw());
+
+        return make_record(RECORD_INFO, body);
+    }
+    default :
+        return UCIEngine::format_info(info, showWDL) + "\n";
+    }
+}
+
+void InfoOutput::on_update_no_moves(const Engine::InfoShort& info) {
+    switch (format())
+    {
+    case JSON :
+        write("{\"type\":\"info\",\"depth\":" + std::to_string(info.depth)
+              + ",\"score\":" + json_score(info.score) + "}\n");
+        break;
+    case BINARY : {
+        std::string body;
+        put(body, u16(info.depth));
+        put_score(body, info.score);
+        write(make_record(RECORD_INFO_NO_MOVES, body));
+        break;
+    }
+    default :
+        write(UCIEngine::format_info(info) + "\n");
+    }
+}
+
+void InfoOutput::on_update_full(const Engine::InfoFull& info) {
+    const TimePoint interval = int(options["InfoInterval"]);
+
+    if (!interval)
+    {
+        write(format_info(info));
+        return;
+    }
+
+    if (pending.size() < info.multiPV)
+        pending.resize(info.multiPV);
+
+    PendingInfo& p = pending[info.multiPV - 1];
+
+    p.info  = info;
+    p.pv    = *info.pv;
+    p.wdl   = info.wdl;
+    p.bound = info.bound;
+
+    if (now() - lastFlush >= interval)
+        flush();
+}
+
+void InfoOutput::on_tick() {
+    if (pending.empty())
+        return;
+
+    const TimePoint interval = int(options["InfoInterval"]);
+
+    if (interval && now() - lastFlush >= interval)
+        flush();
+}
+
+void InfoOutput::on_iter(const Engine::InfoIter& info) {
+    switch (format())
+    {
+    case JSON :
+        write("{\"type\":\"currmove\",\"depth\":" + std::to_string(info.depth)
+              + ",\"currmove\":\"" + std::string(info.currmove)
+              + "\",\"currmovenumber\":" + std::to_string(info.currmovenumber) + "}\n");
+        break;
+    case BINARY : {
+        std::string body;
+        put(body, u16(info.depth));
+        put(body, u16(info.currmovenumber));
+        put_string(body, info.currmove);
+        write(make_record(RECORD_CURRMOVE, body));
+        break;
+    }
+    default :
+        write(UCIEngine::format_info(info) + "\n");
+    }
+}
+
+void InfoOutput::on_bestmove(std::string_view bestmove, std::string_view ponder) {
+    // The final PV must come before the bestmove, and the next search starts a new interval
+    flush();
+    lastFlush = 0;
+
+    switch (format())
+    {
+    case JSON :
+        write("{\"type\":\"bestmove\",\"bestmove\":\"" + std::string(bestmove)
+              + "\",\"ponder\":\"" + std::string(ponder) + "\"}\n");
+        break;
+    case BINARY : {
+        std::string body;
+        put_string(body, bestmove);
+        put_string(body, ponder);
+        write(make_record(RECORD_BESTMOVE, body));
+        break;
+    }
+    default :
+        write(UCIEngine::format_bestmove(bestmove, ponder) + "\n");
+    }
+}
+
+void InfoOutput::flush() {
+    std::string data;
+
+    for (PendingInfo& p : pending)
+        if (p.info.multiPV)
+        {
+            p.info.pv    = &p.pv;
+            p.info.wdl   = p.wdl;
+            p.info.bound = p.bound;
+
+            data += format_info(p.info);
+            p.info.multiPV = 0;
+        }
+
+    // Without anything written, the next update is not held back
+    if (data.empty())
+        return;
+
+    write(data);
+    lastFlush = now();
 }
 
 void UCIEngine::terminate_on_critical_error(const std::string& fullCommand,
@@ -19,13 +19,16 @@
 #ifndef UCI_H_INCLUDED
 #define UCI_H_INCLUDED
 
+#include <functional>
 #include <iostream>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "engine.h"
 #include "misc.h"
 #include "search.h"
+#include "ucioption.h"
 
 namespace Stockfish {
 
@@ -37,6 +40,50 @@ using Value = int;
 
 constexpr auto StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+// Writes the search updates in the format of the UCI_OutputFormat option: UCI text,
+// one JSON object per line, or binary records (see uci.cpp). With InfoInterval set,
+// the PV updates of each interval are coalesced, only the latest one of every multipv
+// is written when the interval is over, or at the latest before the bestmove. The
+// search ticks the output regularly, so that updates held back are written in time
+// even when no further update comes.
+class InfoOutput {
+   public:
+    using Writer = std::function<void(std::string_view)>;
+
+    InfoOutput(const OptionsMap& optionsMap, Writer writer) :
+        options(optionsMap),
+        write(std::move(writer)) {}
+
+    void on_update_no_moves(const Engine::InfoShort& info);
+    void on_update_full(const Engine::InfoFull& info);
+    void on_iter(const Engine::InfoIter& info);
+    void on_bestmove(std::string_view bestmove, std::string_view ponder);
+    void on_tick();
+
+   private:
+    enum Format {
+        TEXT,
+        JSON,
+        BINARY
+    };
+
+    // Copy of an update, which only lives as long as the callback
+    struct PendingInfo {
+        Engine::InfoFull info;
+        Search::PVMoves  pv;
+        std::string      wdl, bound;
+    };
+
+    Format      format() const;
+    std::string format_info(const Engine::InfoFull& info) const;
+    void        flush();
+
+    const OptionsMap&        options;
+    Writer                   write;
+    std::vector<PendingInfo> pending;  // Indexed by multipv, empty when multiPV is 0
+    TimePoint                lastFlush = 0;
+};
+
 class UCIEngine {
    public:
     UCIEngine(int argc, char** argv);
@@ -47,32 +94,40 @@ class UCIEngine {
     static std::string format_score(const Score& s);
     static std::string square(Square s);
     static std::string move(Move m, bool chess960 = false);
+    static std::string format_pv(const Search::PVMoves& pv, bool chess960);
     static std::string wdl(Value v, const Position& pos);
     static std::string to_lower(std::string str);
     static Move        to_move(const Position& pos, std::string str);
 
     static Search::LimitsType parse_limits(std::istream& is);
+    static bool
+    parse_position(std::istream& is, std::string& fen, std::vector<std::string>& moves);
+
+    static std::string format_info(const Engine::InfoShort& info);
+    static std::string format_info(const Engine::InfoFull& info, bool showWDL);
+    static std::string format_info(const Engine::InfoIter& info);
+    static std::string format_bestmove(std::string_view bestmove, std::string_view ponder);
 
     auto& engine_options() { return engine.get_options(); }
 
    private:
     Engine      engine;
     CommandLine cli;
+    InfoOutput  output;
 
     static void print_info_string(std::string_view str);
 
     void go(std::istringstream& is);
     void bench(std::istream& args);
     void benchmark(std::istream& args);
+    void history_bench(std::istream& args);
+    void analyse(std::istream& is);
+    void gensfen(std::istream& is);
+    void serve(std::istream& is);
     void position(std::istringstream& is);
     void setoption(std::istringstream& is);
     u64  perft(const Search::LimitsType&);
 
-    static void on_update_no_moves(const Engine::InfoShort& info);
-    static void on_update_full(const Engine::InfoFull& info, bool showWDL);
-    static void on_iter(const Engine::InfoIter& info);
-    static void on_bestmove(std::string_view bestmove, std::string_view ponder);
-
     void init_search_update_listeners();
 
     [[noreturn]] void terminate_on_critical_error(const std::string& fullCommand,
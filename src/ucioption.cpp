@@ -68,12 +68,11 @@ const Option& OptionsMap::operator[](const std::string& name) const {
 void OptionsMap::add(const std::string& name, const Option& option) {
     if (!options_map.count(name))
     {
-        static usize insert_order = 0;
-
         options_map[name] = option;
 
+        // Count per map, so that the options of several engines all print in order
         options_map[name].parent = this;
-        options_map[name].idx    = insert_order++;
+        options_map[name].idx    = options_map.size() - 1;
     }
     else
     {
@@ -163,7 +162,8 @@ Option& Option::operator=(const std::string& v) {
         std::string        token;
         std::istringstream ss(defaultValue);
         while (ss >> token)
-            comboMap.add(token, Option());
+            if (!comboMap.count(token))  // The default value is listed twice
+                comboMap.add(token, Option());
         if (!comboMap.count(v) || v == "var")
             return *this;
     }
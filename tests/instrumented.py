@@ -1,10 +1,12 @@
 import argparse
+import json
 import re
 import sys
 import subprocess
 import pathlib
 import os
 import fnmatch
+import struct
 
 from testing import (
     EPD,
@@ -338,6 +340,60 @@ class TestInteractive(metaclass=OrderedClassMembers):
 
         self.stockfish.starts_with("bestmove")
 
+    def test_fen_position_go_mate_solver_mate_in_2(self):
+        self.stockfish.send_command("ucinewgame")
+        self.stockfish.send_command(
+            "position fen r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1"
+        )
+        self.stockfish.send_command("go mate 2")
+        self.stockfish.expect("* score mate 2 * pv d5f6 g7f6 c4f7")
+        self.stockfish.starts_with("bestmove d5f6")
+
+    def test_fen_position_go_mate_solver_mate_in_3(self):
+        self.stockfish.send_command("ucinewgame")
+        self.stockfish.send_command(
+            "position fen r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1"
+        )
+        self.stockfish.send_command("go mate 3")
+        self.stockfish.expect("* score mate 3 * pv f8c5 *")
+        self.stockfish.starts_with("bestmove f8c5")
+
+    def test_startpos_go_mate_falls_back_to_search(self):
+        self.stockfish.send_command("ucinewgame")
+        self.stockfish.send_command("position startpos")
+        self.stockfish.send_command("go mate 2")
+
+        # Without a mate the iterations of the normal search follow the solver
+        self.stockfish.expect("info depth 6 * pv *")
+        self.stockfish.send_command("stop")
+        self.stockfish.starts_with("bestmove")
+
+    def test_startpos_go_mate_stop_during_solver(self):
+        self.stockfish.send_command("ucinewgame")
+        self.stockfish.send_command("position startpos")
+        self.stockfish.send_command("go mate 20")
+
+        pv = []
+
+        def callback(output):
+            nonlocal pv
+
+            if output.startswith("info depth"):
+                match = re.search(r" pv (.+)$", output)
+                assert match
+                pv = match.group(1).split()
+
+            if output.startswith("bestmove"):
+                assert pv and output.split()[1] == pv[0]
+                return True
+
+            return bool(pv)
+
+        # The first iteration is searched before the solver, and its move is played
+        self.stockfish.check_output(callback)
+        self.stockfish.send_command("stop")
+        self.stockfish.check_output(callback)
+
     def test_fen_position_with_mate_go_nodes(self):
         self.stockfish.send_command("ucinewgame")
         self.stockfish.send_command(
@@ -411,6 +467,226 @@ class TestInteractive(metaclass=OrderedClassMembers):
 
         self.stockfish.send_command("setoption name Skill Level value 20")
 
+    def test_json_output_format(self):
+        self.stockfish.send_command("setoption name MultiPV value 1")
+        self.stockfish.send_command("setoption name UCI_OutputFormat value json")
+        self.stockfish.send_command("position startpos")
+        self.stockfish.send_command("go depth 8")
+
+        pv = []
+
+        def callback(output):
+            nonlocal pv
+
+            # Messages of the engine stay plain text
+            if output.startswith("info string"):
+                return False
+
+            data = json.loads(output)
+
+            if data["type"] == "info" and "pv" in data:
+                assert isinstance(data["depth"], int) and isinstance(data["nodes"], int)
+                assert len(data["score"]) == 1
+                assert all(isinstance(move, str) for move in data["pv"])
+                pv = data["pv"]
+
+            if data["type"] == "bestmove":
+                assert pv and data["bestmove"] == pv[0]
+                return True
+
+            return False
+
+        self.stockfish.check_output(callback)
+        self.stockfish.send_command("setoption name UCI_OutputFormat value text")
+
+    def test_info_interval_flushes_before_bestmove(self):
+        self.stockfish.send_command("setoption name InfoInterval value 10000")
+        self.stockfish.send_command("position startpos")
+        self.stockfish.send_command("go depth 12")
+
+        lines = []
+
+        def callback(output):
+            if output.startswith("info depth"):
+                lines.append(output)
+
+            return output.startswith("bestmove")
+
+        self.stockfish.check_output(callback)
+
+        # The updates within the interval are held back, but the latest one is written
+        # before the bestmove
+        assert len(lines) < 12
+        assert lines[-1].startswith("info depth 12 ")
+
+        self.stockfish.send_command("setoption name InfoInterval value 0")
+
+
+class TestHashFile(metaclass=OrderedClassMembers):
+    def beforeAll(self):
+        self.stockfish = Stockfish()
+        self.nodes = 0
+
+    def afterAll(self):
+        self.stockfish.quit()
+        assert self.stockfish.close() == 0
+
+    def afterEach(self):
+        assert postfix_check(self.stockfish.get_output()) == True
+        self.stockfish.clear_output()
+
+    def search_nodes(self, position, depth):
+        self.stockfish.send_command(f"position {position}")
+        self.stockfish.send_command(f"go depth {depth}")
+
+        nodes = 0
+
+        def callback(output):
+            nonlocal nodes
+
+            match = re.search(r" nodes (\d+)", output)
+            if match:
+                nodes = int(match.group(1))
+
+            return output.startswith("bestmove")
+
+        self.stockfish.check_output(callback)
+        return nodes
+
+    def read_file(self, path):
+        with open(path, "rb") as f:
+            return f.read()
+
+    def test_export_hash(self):
+        self.stockfish.send_command(f"setoption name Threads value {get_threads()}")
+        self.stockfish.send_command("setoption name Hash value 16")
+        self.stockfish.send_command("ucinewgame")
+        self.nodes = self.search_nodes("startpos", 12)
+
+        self.stockfish.send_command("export_hash hash.bin")
+        self.stockfish.equals("Hash saved successfully to hash.bin")
+
+    def test_import_hash_round_trip(self):
+        self.stockfish.send_command("ucinewgame")
+        self.stockfish.send_command("import_hash hash.bin")
+        self.stockfish.equals("Hash loaded successfully from hash.bin (16 MiB)")
+
+        # The entries of the first search are found again
+        assert self.search_nodes("startpos", 12) < self.nodes
+
+    def test_import_hash_copy_on_write(self):
+        before = self.read_file("hash.bin")
+
+        self.stockfish.send_command("import_hash hash.bin")
+        self.stockfish.equals("Hash loaded successfully from hash.bin (16 MiB)")
+        self.search_nodes("startpos moves e2e4 c7c5", 10)
+
+        assert self.read_file("hash.bin") == before
+
+    def test_import_hash_shared(self):
+        before = self.read_file("hash.bin")
+
+        self.stockfish.send_command("import_hash hash.bin shared")
+        self.stockfish.equals("Hash loaded successfully from hash.bin (16 MiB)")
+        self.search_nodes("startpos moves d2d4 g8f6", 10)
+
+        after = self.read_file("hash.bin")
+
+        # The entries and the generation in the header are written back to the file
+        assert after[64 * 1024 :] != before[64 * 1024 :]
+        assert after[24] != before[24]
+
+        # Reallocating the table leaves the file alone
+        self.stockfish.send_command("setoption name Hash value 16")
+        self.search_nodes("startpos moves c2c4", 8)
+        assert self.read_file("hash.bin") == after
+
+    def test_import_hash_bad_file(self):
+        with open("bad.bin", "wb") as f:
+            f.write(b"\0" * 4096)
+
+        with open("truncated.bin", "wb") as f:
+            f.write(self.read_file("hash.bin")[: 1024 * 1024])
+
+        for file in ["bad.bin", "truncated.bin", "missing.bin"]:
+            self.stockfish.send_command(f"import_hash {file}")
+            self.stockfish.equals(f"Failed to load hash from {file}")
+
+        # The table in use is kept
+        self.search_nodes("startpos", 5)
+
+
+class TestBook(metaclass=OrderedClassMembers):
+    # Positions with the reference keys of the Polyglot format, each given a book
+    # move which the engine must play without searching
+    POSITIONS = [
+        ("", 0x463B96181691FC9C, "b1c3"),
+        ("e2e4", 0x823C9B50FD114196, "g8f6"),
+        ("e2e4 d7d5", 0x0756B94461C50FB0, "e4d5"),
+        ("e2e4 d7d5 e4e5", 0x662FAFB965DB29D4, "f7f5"),
+        ("e2e4 d7d5 e4e5 f7f5", 0x22A48B5A8E47FF78, "e5f6"),
+        ("e2e4 d7d5 e4e5 f7f5 e1e2", 0x652A607CA3F242C1, "e8f7"),
+        ("e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", 0x00FDD303C946BDD9, "d2d4"),
+        ("a2a4 b7b5 h2h4 b5b4 c2c4", 0x3C8123EA7B067637, "b4c3"),
+        ("a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5C3F9B829B279560, "c3b2"),
+    ]
+
+    def beforeAll(self):
+        self.stockfish = Stockfish()
+
+    def afterAll(self):
+        self.stockfish.quit()
+        assert self.stockfish.close() == 0
+
+    def afterEach(self):
+        assert postfix_check(self.stockfish.get_output()) == True
+        self.stockfish.clear_output()
+
+    def polyglot_move(self, move):
+        def square(s):
+            return (ord(s[0]) - ord("a")) | (int(s[1]) - 1) << 3
+
+        return square(move[2:4]) | square(move[0:2]) << 6
+
+    def play(self, moves):
+        self.stockfish.send_command(f"position startpos moves {moves}".strip())
+        self.stockfish.send_command("go depth 10")
+
+        searched = False
+        bestmove = None
+
+        def callback(output):
+            nonlocal searched, bestmove
+
+            if output.startswith("info depth"):
+                searched = True
+
+            if output.startswith("bestmove"):
+                bestmove = output.split()[1]
+                return True
+
+            return False
+
+        self.stockfish.check_output(callback)
+        return searched, bestmove
+
+    def test_book_file(self):
+        with open("book.bin", "wb") as f:
+            for _, key, move in sorted(self.POSITIONS, key=lambda p: p[1]):
+                f.write(struct.pack(">QHHI", key, self.polyglot_move(move), 1, 0))
+
+        self.stockfish.send_command(f"setoption name Threads value {get_threads()}")
+        self.stockfish.send_command("setoption name BookFile value book.bin")
+        self.stockfish.equals(f"info string Book book.bin with {len(self.POSITIONS)} entries")
+
+    def test_polyglot_keys(self):
+        for moves, _, move in self.POSITIONS:
+            assert self.play(moves) == (False, move)
+
+    def test_position_not_in_book(self):
+        searched, bestmove = self.play("g1f3")
+        assert searched and bestmove
+
 
 class TestSyzygy(metaclass=OrderedClassMembers):
     def beforeAll(self):
@@ -595,7 +871,16 @@ if __name__ == "__main__":
     framework = MiniTestFramework()
 
     # Each test suite will be run inside a temporary directory
-    framework.run([TestCLI, TestInteractive, TestSyzygy, TestEnPassantSanitization])
+    framework.run(
+        [
+            TestCLI,
+            TestInteractive,
+            TestHashFile,
+            TestBook,
+            TestSyzygy,
+            TestEnPassantSanitization,
+        ]
+    )
 
     EPD.delete_bench_epd()
 
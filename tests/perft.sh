@@ -84,7 +84,66 @@ run_test "fen rr6/2kpp3/1ppnb1p1/p4q1p/P4P1P/1PNN2P1/2PP2Q1/1K2RR2 w E - 1 19" 4
 run_test "fen rr6/2kpp3/1ppnb1p1/p4q1p/P4P1P/1PNN2P1/2PP2Q1/1K2RR2 w E - 1 19" 5 79014522 "true"
 run_test "fen rr6/2kpp3/1ppnb1p1/p4q1p/P4P1P/1PNN2P1/2PP2Q1/1K2RR2 w E - 1 19" 6 2998685421 "true"
 
-rm -f $EXPECT_SCRIPT
+# perftsuite, on EPD files with the expected counts of several depths
+
+SUITE_SCRIPT=$(mktemp)
+SUITE_FILE=$(mktemp)
+
+cat << 'EOF' > $SUITE_SCRIPT
+#!/usr/bin/expect -f
+set timeout 120
+lassign [lrange $argv 0 2] file result logfile
+log_file -noappend $logfile
+spawn ./stockfish
+send "perftsuite $file\n"
+expect {
+  "$result" {}
+  timeout {puts "TIMEOUT: Expected $result"; exit 1}
+  eof {puts "EOF: Stockfish crashed"; exit 2}
+}
+send "quit\n"
+expect eof
+EOF
+
+chmod +x $SUITE_SCRIPT
+
+run_suite_test() {
+  local name="$1"
+  local expected="$2"
+  local tmp_file=$(mktemp)
+
+  echo -n "Testing perftsuite: $name... "
+
+  if $SUITE_SCRIPT "$SUITE_FILE" "$expected" "$tmp_file" > /dev/null 2>&1; then
+    echo "OK"
+    rm -f "$tmp_file"
+  else
+    local exit_code=$?
+    echo "FAILED (exit code: $exit_code)"
+    echo "===== Output for failed test ====="
+    cat "$tmp_file"
+    echo "=================================="
+    rm -f "$tmp_file"
+    TESTS_FAILED=1
+  fi
+}
+
+cat << 'EOF' > $SUITE_FILE
+rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1 20 ;D2 400 ;D3 8902 ;D4 197281
+r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - ;D1 48 ;D2 2039 ;D3 97862
+8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - ;D1 14 ;D2 191 ;D3 2812 ;D4 43238
+EOF
+
+run_suite_test "valid counts" "Mismatches      : 0"
+
+cat << 'EOF' > $SUITE_FILE
+rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - ;D1 20 ;D2 401
+8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - ;D ;Dx 14 ;D99999999999 1 ;D1 14
+EOF
+
+run_suite_test "wrong and malformed counts" "Mismatches      : 4"
+
+rm -f $EXPECT_SCRIPT $SUITE_SCRIPT $SUITE_FILE
 echo "perft testing completed"
 
 if [ $TESTS_FAILED -ne 0 ]; then